@@ -10,4 +10,6 @@
 
 extern int flag_tsan;
 extern const char *flag_tsan_ignore;
+extern int flag_tsan_stats;
+extern int flag_tsan_clones;
 
@@ -15,7 +15,7 @@
 //#include <stdarg.h>
 
 
-static IgnoreLists* g_ignore;
+static IgnoreMatchers* g_ignore;
 
 
 void                    relite_ignore_init  (char const* file_name) {
@@ -25,35 +25,43 @@ void                    relite_ignore_init  (char const* file_name) {
   std::string const& file_data = ReadFileToString(file_name, true);
   if (file_data.empty())
     return;
-  g_ignore = new IgnoreLists;
-  ReadIgnoresFromString(file_data, g_ignore);
+  IgnoreLists lists;
+  ReadIgnoresFromString(file_data, &lists);
+  g_ignore = new IgnoreMatchers;
+  g_ignore->Init(lists);
 }
 
 
 int                     relite_ignore_file  (char const* file) {
   if (g_ignore != 0) {
-    return TripleVectorMatchKnown(g_ignore->ignores,
-                                  std::string(),
-                                  std::string(),
-                                  file);
+    return g_ignore->ignores.Match(std::string(),
+                                   std::string(),
+                                   file);
   } else {
     return 0;
   }
 }
 
 
-relite_ignore_e         relite_ignore_func  (char const* func) {
+relite_ignore_e         relite_ignore_func  (char const* func,
+                                             char const* demangled) {
   if (g_ignore != 0) {
     std::string const empty;
     std::string const func_str (func);
-    if (TripleVectorMatchKnown(g_ignore->ignores_r,
-                               func_str, empty, empty)) {
+    std::string const demangled_str (demangled ? demangled : "");
+    if (g_ignore->ignores_r.MatchFunction(func_str, demangled_str, empty)) {
       return relite_ignore_rec;
-    } else if (TripleVectorMatchKnown(g_ignore->ignores_hist,
-                                      func_str, empty, empty)) {
+    } else if (g_ignore->ignores_hist.MatchFunction(func_str, demangled_str,
+                                                    empty)) {
       return relite_ignore_hist;
-    } else if (TripleVectorMatchKnown(g_ignore->ignores,
-                                      func_str, empty, empty)) {
+    } else if (g_ignore->ignores.MatchFunction(func_str, demangled_str,
+                                               empty)
+               // fun_sync: ("instrument synchronization only") is an alias
+               // of fun: here, synchronization is intercepted by the runtime
+               // and relite_ignore_mop keeps the calls instrumented anyway.
+               || g_ignore->ignores_sync.MatchFunction(func_str,
+                                                       demangled_str,
+                                                       empty)) {
       return relite_ignore_mop;
     }
   }
@@ -25,7 +25,8 @@ typedef enum relite_ignore_e {
 
 void                    relite_ignore_init  (char const* file_name);
 int                     relite_ignore_file  (char const* file);
-relite_ignore_e         relite_ignore_func  (char const* func);
+relite_ignore_e         relite_ignore_func  (char const* func,
+                                             char const* demangled);
 
 
 #ifdef __cplusplus
@@ -977,7 +977,8 @@ void                    relite_pass         (relite_context_t* ctx) {
   ctx->stat_func_instrumented += 1;
 
   char const* asm_name = IDENTIFIER_POINTER(DECL_ASSEMBLER_NAME(cfun->decl));
-  ctx->func_ignore = relite_ignore_func(asm_name);
+  ctx->func_ignore = relite_ignore_func(asm_name,
+      lang_hooks.decl_printable_name(cfun->decl, 2));
 
   instrument_function(ctx);
 
@@ -37,6 +37,7 @@ along with GCC; see the file COPYING3.  If not see
 #include "target.h"
 #include "cgraph.h"
 #include "diagnostic.h"
+#include "pointer-set.h"
 
 #include <stdlib.h>
 #include <stdio.h>
@@ -79,6 +80,29 @@ along with GCC; see the file COPYING3.  If not see
      __tsan_thread_ignore--;
    }
 
+   Accesses that are dominated by an identical access with no call
+   in between are not instrumented, and adjacent accesses to fields
+   of the same object are merged into a single range access
+   (see optimize_mops function).  Per-file instrumentation statistics
+   are printed with -fplugin-arg-tsan-stats.
+
+   With -fplugin-arg-tsan-clones each instrumented function gets
+   an uninstrumented clone and a descriptor in the __tsan_funcs section:
+   static void *__tsan_func_desc [4] = {somefunc, (void*)1, (void*)mops, 0};
+   void somefunc (args)
+   {
+     if (__tsan_func_desc [1] == 0)
+       {
+         __tsan_func_desc [3] += 1;
+         return somefunc.tsan_uninst (args);
+       }
+     // instrumented function body
+   }
+   The run-time library clears the flag for ignored functions,
+   so that they run without instrumentation overhead.  MOPS is the number
+   of instrumented accesses in the function; together with the count
+   of the clone calls it tells how much instrumentation was skipped.
+
    The run-time library provides __tsan_handle_mop function,
    definitions of __tsan_shadow_stack and __tsan_thread_ignore variables,
    and intercepts synchronization related functions.  */
@@ -88,8 +112,11 @@ along with GCC; see the file COPYING3.  If not see
 #define TSAN_MOP "__tsan_handle_mop"
 #define TSAN_INIT "__tsan_init"
 #define TSAN_PERFIX "__tsan_"
+#define TSAN_FUNCS_SECTION "__tsan_funcs"
+#define TSAN_CLONE_SUFFIX "tsan_uninst"
 #define MAX_MOP_BYTES 16
 #define SBLOCK_SIZE 5
+#define MAX_AVAIL_MOPS 64
 
 enum tsan_ignore_type
 {
@@ -100,8 +127,27 @@ enum tsan_ignore_type
   tsan_ignore_hist  = 1 << 4  /* Do not create superblocks.  */
 };
 
+/* Memory access descriptor.  */
+
+struct mop_desc
+{
+  int                  is_call;
+  int                  is_store;
+  int                  is_removed;
+  unsigned             size;     /* Size of a merged range access or 0.  */
+  gimple_stmt_iterator gsi;
+  tree                 expr;
+  tree                 vptr_rhs; /* See is_vptr_store ().  */
+};
+
+typedef struct mop_desc mop_desc;
+DEF_VEC_O (mop_desc);
+DEF_VEC_ALLOC_O (mop_desc, heap);
+static VEC (mop_desc, heap) *mop_list;
+
 /* Info associated with each basic block.
-   Used to determine super-blocks (see instrument_mops ()).  */
+   Used to determine super-blocks (see instrument_mops ())
+   and redundant accesses (see optimize_mops ()).  */
 
 struct bb_data
 {
@@ -110,16 +156,8 @@ struct bb_data
   const char *sb_file;
   int         sb_line_min;
   int         sb_line_max;
-};
-
-/* Memory access descriptor.  */
-
-struct mop_desc
-{
-  int                  is_call;
-  int                  is_store;
-  gimple_stmt_iterator gsi;
-  tree                 expr;
+  /* Accesses not separated from the end of the block by a call.  */
+  VEC (mop_desc, heap) *avail;
 };
 
 /* Descriptor of an ignore file entry.  */
@@ -129,6 +167,9 @@ struct tsan_ignore_desc
   struct tsan_ignore_desc *next;
   enum tsan_ignore_type    type;
   char                    *name;
+  /* The name split by '*' at load time (see ignore_match ()).  */
+  const char             **pieces;
+  int                      npieces;
 };
 
 /* Number of instrumented memory accesses in the current function.  */
@@ -146,10 +187,24 @@ static enum tsan_ignore_type func_ignore;
 static int ignore_init = 0;
 static struct tsan_ignore_desc *ignore_head;
 
-typedef struct mop_desc mop_desc;
-DEF_VEC_O (mop_desc);
-DEF_VEC_ALLOC_O (mop_desc, heap);
-static VEC (mop_desc, heap) *mop_list;
+/* Uninstrumented clones created with -fplugin-arg-tsan-clones.  */
+
+static struct pointer_set_t *uninst_clones;
+
+/* Per-file instrumentation statistics.  */
+
+static struct
+{
+  int funcs;
+  int ignored_funcs;
+  int bbs;
+  int mops;
+  int inst_mops;
+  int redundant_mops;
+  int merged_mops;
+  int cloned_funcs;
+  int cloned_mops;
+} tsan_stats;
 
 /* Returns a definition of a runtime variable with type TYP and name NAME.  */
 
@@ -278,45 +333,37 @@ static void
 ignore_append (enum tsan_ignore_type type, char *name)
 {
   struct tsan_ignore_desc *desc;
+  char *pos;
 
   desc = XCNEW (struct tsan_ignore_desc);
   desc->type = type;
   desc->name = xstrdup (name);
+  /* Split the template into non-empty pieces once,
+     so that matching does not need to parse it.  */
+  desc->pieces = XNEWVEC (const char *, strlen (name) / 2 + 1);
+  for (pos = strtok (desc->name, "*"); pos != NULL; pos = strtok (NULL, "*"))
+    desc->pieces [desc->npieces++] = pos;
   desc->next = ignore_head;
   ignore_head = desc;
 }
 
-/* Checks as to whether identifier STR matches template TEMPL.
+/* Checks as to whether identifier STR matches template DESC.
    Templates can only contain '*', e.g. 'std*string*insert'.
    Templates implicitly start and end with '*'
    since they are matched against mangled names.
-   Returns non-zero if STR is matched against TEMPL.  */
+   Returns non-zero if STR is matched against DESC.  */
 
 static int
-ignore_match (char *templ, const char *str)
+ignore_match (const struct tsan_ignore_desc *desc, const char *str)
 {
-  char *tpos;
-  const char *spos;
+  int i;
 
-  while (templ && templ [0])
+  for (i = 0; i != desc->npieces; i++)
     {
-      if (templ [0] == '*')
-        {
-          templ++;
-          continue;
-        }
-      if (str [0] == 0)
-        return 0;
-      tpos = strchr (templ, '*');
-      if (tpos != NULL)
-        tpos [0] = 0;
-      spos = strstr (str, templ);
-      str = spos + strlen (templ);
-      templ = tpos;
-      if (tpos != NULL)
-        tpos [0] = '*';
-      if (spos == NULL)
+      str = strstr (str, desc->pieces [i]);
+      if (str == NULL)
         return 0;
+      str += strlen (desc->pieces [i]);
     }
   return 1;
 }
@@ -340,6 +387,12 @@ fun_r:foobar
 # in the function called 'barbaz'
 fun_hist:barbaz
 
+# The below line says to instrument only synchronization
+# in the function called 'refcount_inc'. Synchronization is intercepted
+# by the runtime, so here it is an alias of fun: (calls and the shadow
+# stack are instrumented, memory accesses are not)
+fun_sync:refcount_inc
+
 # Ignore all functions in the source file
 src:atomic.c
 
@@ -404,6 +457,9 @@ ignore_load (void)
         ignore_append (tsan_ignore_rec, line + sizeof ("fun_r:") - 1);
       else if (strncmp (line, "fun_hist:", sizeof ("fun_hist:") - 1) == 0)
         ignore_append (tsan_ignore_hist, line + sizeof ("fun_hist:") - 1);
+      /* Same as fun:, see above.  */
+      else if (strncmp (line, "fun_sync:", sizeof ("fun_sync:") - 1) == 0)
+        ignore_append (tsan_ignore_mop, line + sizeof ("fun_sync:") - 1);
       /* Other lines are not interesting.  */
     }
 
@@ -447,11 +503,11 @@ tsan_ignore (void)
     {
       if (desc->type == tsan_ignore_func)
         {
-          if (ignore_match (desc->name, src_name))
-           return desc->type;
+          if (ignore_match (desc, src_name))
+            return desc->type;
         }
-      else if (ignore_match (desc->name, func_name))
-       return desc->type;
+      else if (ignore_match (desc, func_name))
+        return desc->type;
     }
   return tsan_ignore_none;
 }
@@ -538,15 +594,16 @@ build_stack_assign (gimple_seq *seq)
 
 /* Builds the following gimple sequence:
    __tsan_handle_mop (&EXPR,
-                      (IS_SBLOCK | (IS_STORE << 1) | ((sizeof (EXPR) - 1) << 2);
+                      (IS_SBLOCK | (IS_STORE << 1) | ((SIZE - 1) << 2);
+   If SIZE is 0, sizeof (EXPR) is used.
    The result is stored in GSEQ.  */
 
 static void
-instr_mop (tree expr, int is_store, int is_sblock, gimple_seq *gseq)
+instr_mop (tree expr, int is_store, int is_sblock, unsigned size,
+           gimple_seq *gseq)
 {
   tree addr_expr;
   tree expr_type;
-  unsigned size;
   unsigned flags;
   tree flags_expr;
   tree call_expr;
@@ -555,11 +612,14 @@ instr_mop (tree expr, int is_store, int is_sblock, gimple_seq *gseq)
   gcc_assert (is_gimple_addressable (expr));
 
   addr_expr = build_addr (unshare_expr (expr), current_function_decl);
-  expr_type = TREE_TYPE (expr);
-  while (TREE_CODE (expr_type) == ARRAY_TYPE)
-    expr_type = TREE_TYPE (expr_type);
-  size = TREE_INT_CST_LOW (TYPE_SIZE (expr_type));
-  size = size / BITS_PER_UNIT;
+  if (size == 0)
+    {
+      expr_type = TREE_TYPE (expr);
+      while (TREE_CODE (expr_type) == ARRAY_TYPE)
+        expr_type = TREE_TYPE (expr_type);
+      size = TREE_INT_CST_LOW (TYPE_SIZE (expr_type));
+      size = size / BITS_PER_UNIT;
+    }
   if (size > MAX_MOP_BYTES)
     size = MAX_MOP_BYTES;
   size -= 1;
@@ -786,10 +846,11 @@ handle_expr (gimple_stmt_iterator gsi, tree expr, int is_store,
       && tcode != MEM_REF)
     return;
 
-  mop.is_call = 0;
+  memset (&mop, 0, sizeof (mop));
   mop.gsi = gsi;
   mop.expr = expr;
   mop.is_store = is_store;
+  mop.vptr_rhs = is_vptr_store (gsi_stmt (gsi), expr, is_store);
   VEC_safe_push (mop_desc, heap, *mop_list, &mop);
 }
 
@@ -842,6 +903,133 @@ handle_gimple (gimple_stmt_iterator gsi, VEC (mop_desc, heap) **mop_list)
     }
 }
 
+/* Checks as to whether access MOP is redundant because of an earlier
+   access PREV to the same memory with no call in between.
+   A store covers both loads and stores, a load covers only loads.
+   A vptr store can turn out to be a load at run-time.  */
+
+static int
+is_mop_covered (struct mop_desc *prev, struct mop_desc *mop)
+{
+  if (mop->vptr_rhs != NULL
+      || (mop->is_store && (!prev->is_store || prev->vptr_rhs != NULL))
+      || TREE_THIS_VOLATILE (prev->expr)
+      || TREE_THIS_VOLATILE (mop->expr))
+    return 0;
+  return operand_equal_p (prev->expr, mop->expr, 0);
+}
+
+/* If EXPR is an access to a non-array field with known position,
+   stores the byte range of the field into POS/SIZE
+   and returns the object that contains the field.  */
+
+static tree
+get_field_range (tree expr, HOST_WIDE_INT *pos, HOST_WIDE_INT *size)
+{
+  tree field;
+
+  if (TREE_CODE (expr) != COMPONENT_REF || TREE_THIS_VOLATILE (expr))
+    return NULL_TREE;
+  field = TREE_OPERAND (expr, 1);
+  if (TREE_CODE (field) != FIELD_DECL
+      || TREE_CODE (TREE_TYPE (field)) == ARRAY_TYPE
+      || DECL_SIZE_UNIT (field) == NULL_TREE
+      || !host_integerp (DECL_SIZE_UNIT (field), 1)
+      || TREE_CODE (DECL_FIELD_OFFSET (field)) != INTEGER_CST)
+    return NULL_TREE;
+  *pos = int_byte_position (field);
+  *size = tree_low_cst (DECL_SIZE_UNIT (field), 1);
+  return TREE_OPERAND (expr, 0);
+}
+
+/* Tries to merge access MOP into the range access HEAD.
+   Both must access adjacent or overlapping fields of the same object.  */
+
+static int
+merge_mops (struct mop_desc *head, struct mop_desc *mop)
+{
+  tree head_obj;
+  tree mop_obj;
+  HOST_WIDE_INT head_pos, head_size;
+  HOST_WIDE_INT mop_pos, mop_size;
+  HOST_WIDE_INT beg, end;
+
+  if (head->is_store != mop->is_store
+      || head->vptr_rhs != NULL
+      || mop->vptr_rhs != NULL)
+    return 0;
+  head_obj = get_field_range (head->expr, &head_pos, &head_size);
+  mop_obj = get_field_range (mop->expr, &mop_pos, &mop_size);
+  if (head_obj == NULL_TREE || mop_obj == NULL_TREE
+      || !operand_equal_p (head_obj, mop_obj, 0))
+    return 0;
+  if (head->size != 0)
+    head_size = head->size;
+  if (mop_pos > head_pos + head_size || head_pos > mop_pos + mop_size)
+    return 0;
+  beg = MIN (head_pos, mop_pos);
+  end = MAX (head_pos + head_size, mop_pos + mop_size);
+  if (end - beg > MAX_MOP_BYTES)
+    return 0;
+  /* The range starts at the lower field.  The object is the same,
+     so the expression is valid at the place of HEAD as well.  */
+  if (mop_pos < head_pos)
+    head->expr = mop->expr;
+  head->size = end - beg;
+  return 1;
+}
+
+/* Marks accesses in MOP_LIST that do not need instrumentation:
+   accesses dominated by an identical access with no call in between
+   (BBD->AVAIL holds such accesses on entry into the block),
+   and accesses merged into a range access with an adjacent field.
+   On return BBD->AVAIL holds accesses available at the end of the block.  */
+
+static void
+optimize_mops (struct bb_data *bbd, VEC (mop_desc, heap) *mop_list)
+{
+  int ix;
+  int j;
+  struct mop_desc *mop;
+  struct mop_desc *prev;
+  struct mop_desc *head;
+
+  head = NULL;
+  for (ix = 0; VEC_iterate (mop_desc, mop_list, ix, mop); ix += 1)
+    {
+      if (mop->is_call != 0)
+        {
+          VEC_truncate (mop_desc, bbd->avail, 0);
+          head = NULL;
+          continue;
+        }
+
+      tsan_stats.mops += 1;
+      for (j = 0; VEC_iterate (mop_desc, bbd->avail, j, prev); j += 1)
+        {
+          if (is_mop_covered (prev, mop))
+            {
+              mop->is_removed = 1;
+              tsan_stats.redundant_mops += 1;
+              break;
+            }
+        }
+      if (mop->is_removed)
+        continue;
+
+      if (VEC_length (mop_desc, bbd->avail) < MAX_AVAIL_MOPS)
+        VEC_safe_push (mop_desc, heap, bbd->avail, mop);
+
+      if (head != NULL && merge_mops (head, mop))
+        {
+          mop->is_removed = 1;
+          tsan_stats.merged_mops += 1;
+          continue;
+        }
+      head = mop;
+    }
+}
+
 /* Instruments single basic block BB.
    BBD is the sblock info associated with the block.  */
 
@@ -856,7 +1044,6 @@ instrument_bblock (struct bb_data *bbd, basic_block bb)
   location_t loc;
   expanded_location eloc;
   gimple_seq instr_seq;
-  tree rhs;
 
   /* Iterate over all gimples and collect interesting mops into mop_list.  */
   VEC_free (mop_desc, heap, mop_list);
@@ -865,6 +1052,8 @@ instrument_bblock (struct bb_data *bbd, basic_block bb)
       handle_gimple (gsi, &mop_list);
     }
 
+  optimize_mops (bbd, mop_list);
+
   mop = 0;
   for (ix = 0; VEC_iterate (mop_desc, mop_list, ix, mop); ix += 1)
     {
@@ -876,7 +1065,11 @@ instrument_bblock (struct bb_data *bbd, basic_block bb)
           continue;
         }
 
+      if (mop->is_removed)
+        continue;
+
       func_mops += 1;
+      tsan_stats.inst_mops += 1;
       stmt = gsi_stmt (mop->gsi);
       loc = gimple_location (stmt);
       eloc = expand_location (loc);
@@ -902,11 +1095,11 @@ instrument_bblock (struct bb_data *bbd, basic_block bb)
         }
 
       instr_seq = 0;
-      rhs = is_vptr_store (stmt, mop->expr, mop->is_store);
-      if (rhs == NULL)
-        instr_mop (mop->expr, mop->is_store, is_sblock, &instr_seq);
+      if (mop->vptr_rhs == NULL)
+        instr_mop (mop->expr, mop->is_store, is_sblock, mop->size,
+                   &instr_seq);
       else
-        instr_vptr_store (mop->expr, rhs, is_sblock, &instr_seq);
+        instr_vptr_store (mop->expr, mop->vptr_rhs, is_sblock, &instr_seq);
       gcc_assert (instr_seq != 0);
       set_location (instr_seq, loc);
       /* Instrumentation for assignment of a function result
@@ -996,10 +1189,22 @@ instrument_mops (void)
             }
         }
 
+      /* A block with a single predecessor is dominated by it,
+         so accesses available at the end of the predecessor
+         are available at the beginning of the block.  */
+      if (single_pred_p (bb))
+        {
+          pred = &bb_data [single_pred (bb)->index];
+          if (pred->is_visited && pred != bbd)
+            bbd->avail = VEC_copy (mop_desc, heap, pred->avail);
+        }
+
       instrument_bblock (bbd, bb);
       bbd->is_visited = 1;
     }
 
+  for (i = 0; i < last_basic_block + NUM_FIXED_BLOCKS; i++)
+    VEC_free (mop_desc, heap, bb_data [i].avail);
   free (blocks_inverted);
   free (bb_data);
 }
@@ -1053,22 +1258,226 @@ instrument_func_exit (void)
     }
 }
 
+/* Checks as to whether the current function needs and supports
+   an uninstrumented clone (see instrument_func_dispatch ()).  */
+
+static bool
+is_func_clone_required (void)
+{
+  basic_block bb;
+  gimple_stmt_iterator gsi;
+  gimple stmt;
+  tree fndecl;
+
+  fndecl = current_function_decl;
+  if (func_ignore == tsan_ignore_mop
+      || func_ignore == tsan_ignore_rec
+      || stdarg_p (TREE_TYPE (fndecl))
+      || cfun->calls_setjmp
+      || cfun->has_nonlocal_label
+      || aggregate_value_p (DECL_RESULT (fndecl), fndecl)
+      || !tree_versionable_function_p (fndecl))
+    return false;
+
+  /* The clone only pays off if there are memory accesses.  */
+  FOR_EACH_BB (bb)
+    {
+      for (gsi = gsi_start_bb (bb); !gsi_end_p (gsi); gsi_next (&gsi))
+        {
+          stmt = gsi_stmt (gsi);
+          if (!is_gimple_call (stmt) && gimple_vuse (stmt) != NULL_TREE)
+            return true;
+        }
+    }
+  return false;
+}
+
+/* Returns an uninstrumented copy of the current function.
+   Must be called before the function is instrumented.  */
+
+static tree
+build_uninstrumented_clone (void)
+{
+  struct cgraph_node *clone;
+
+  clone = cgraph_function_versioning (cgraph_node (current_function_decl),
+                                      NULL, NULL, NULL, NULL, NULL,
+                                      TSAN_CLONE_SUFFIX);
+  if (clone == NULL)
+    return NULL_TREE;
+  if (uninst_clones == NULL)
+    uninst_clones = pointer_set_create ();
+  pointer_set_insert (uninst_clones, clone->decl);
+  return clone->decl;
+}
+
+/* Builds the following decl
+   static void *__tsan_func_desc [4] =
+     {current_function, (void*)1, (void*)func_mops, 0};
+   in the TSAN_FUNCS_SECTION section.  */
+
+static tree
+build_func_desc_decl (void)
+{
+  static int desc_seq;
+  char name [64];
+  tree typ;
+  tree decl;
+  tree init;
+
+  typ = build_array_type (ptr_type_node, build_index_type (size_int (3)));
+  snprintf (name, sizeof (name), "__tsan_func_desc.%d", desc_seq++);
+  decl = build_decl (UNKNOWN_LOCATION, VAR_DECL, get_identifier (name), typ);
+  TREE_STATIC (decl) = 1;
+  TREE_PUBLIC (decl) = 0;
+  DECL_ARTIFICIAL (decl) = 1;
+  DECL_IGNORED_P (decl) = 1;
+  DECL_PRESERVE_P (decl) = 1;
+  TREE_USED (decl) = 1;
+  /* The flag is changed by the run-time library.  */
+  TREE_THIS_VOLATILE (decl) = 1;
+  DECL_SECTION_NAME (decl) = build_string (strlen (TSAN_FUNCS_SECTION),
+                                           TSAN_FUNCS_SECTION);
+  init = tree_cons (size_int (3), null_pointer_node, NULL_TREE);
+  init = tree_cons (size_int (2), build_int_cst (ptr_type_node, func_mops),
+                    init);
+  init = tree_cons (size_one_node, build_int_cst (ptr_type_node, 1), init);
+  init = tree_cons (size_zero_node,
+                    build_fold_addr_expr (current_function_decl), init);
+  DECL_INITIAL (decl) = build_constructor_from_list (typ, init);
+  TREE_STATIC (DECL_INITIAL (decl)) = 1;
+  varpool_finalize_decl (decl);
+  return decl;
+}
+
+/* Inserts dispatch to the uninstrumented CLONE at function entry.
+   The dispatch precedes the shadow stack maintenance,
+   so the clone does not touch the shadow stack at all.
+   Calls of the clone are counted in the descriptor.  */
+
+static void
+instrument_func_dispatch (tree clone)
+{
+  tree desc;
+  tree flag;
+  tree calls;
+  tree parm;
+  tree arg;
+  tree ret_type;
+  tree retval;
+  gimple_seq seq;
+  gimple cond;
+  gimple call;
+  basic_block cond_bb;
+  basic_block call_bb;
+  edge false_edge;
+  edge true_edge;
+  gimple_stmt_iterator gsi;
+  VEC (tree, heap) *args;
+
+  /* The flag check goes into a new block before the first BB.  */
+  desc = build_func_desc_decl ();
+  cond_bb = split_edge (single_succ_edge (ENTRY_BLOCK_PTR));
+  seq = NULL;
+  flag = build4 (ARRAY_REF, ptr_type_node, desc, size_one_node,
+                 NULL_TREE, NULL_TREE);
+  flag = force_gimple_operand (flag, &seq, true, NULL_TREE);
+  cond = gimple_build_cond (EQ_EXPR, flag, null_pointer_node,
+                            NULL_TREE, NULL_TREE);
+  gimple_seq_add_stmt (&seq, cond);
+  set_location (seq, cfun->function_start_locus);
+  gsi = gsi_start_bb (cond_bb);
+  gsi_insert_seq_after (&gsi, seq, GSI_NEW_STMT);
+
+  /* If the flag is set, proceed to the instrumented body.  */
+  false_edge = single_succ_edge (cond_bb);
+  false_edge->flags &= ~EDGE_FALLTHRU;
+  false_edge->flags |= EDGE_FALSE_VALUE;
+  false_edge->probability = REG_BR_PROB_BASE;
+
+  /* Otherwise, call the clone and return its result.  */
+  call_bb = create_empty_bb (cond_bb);
+  true_edge = make_edge (cond_bb, call_bb, EDGE_TRUE_VALUE);
+  true_edge->probability = 0;
+  make_edge (call_bb, EXIT_BLOCK_PTR, 0);
+
+  seq = NULL;
+  calls = build4 (ARRAY_REF, ptr_type_node, desc, size_int (3),
+                  NULL_TREE, NULL_TREE);
+  calls = build2 (MODIFY_EXPR, ptr_type_node, calls,
+                  build2 (POINTER_PLUS_EXPR, ptr_type_node,
+                          unshare_expr (calls), size_one_node));
+  force_gimple_operand (calls, &seq, true, NULL_TREE);
+  args = NULL;
+  for (parm = DECL_ARGUMENTS (current_function_decl);
+       parm != NULL_TREE; parm = DECL_CHAIN (parm))
+    {
+      if (is_gimple_reg (parm))
+        {
+          arg = gimple_default_def (cfun, parm);
+          if (arg == NULL_TREE)
+            {
+              arg = make_ssa_name (parm, gimple_build_nop ());
+              set_default_def (parm, arg);
+            }
+        }
+      else
+        arg = force_gimple_operand (parm, &seq, true, NULL_TREE);
+      VEC_safe_push (tree, heap, args, arg);
+    }
+  call = gimple_build_call_vec (clone, args);
+  VEC_free (tree, heap, args);
+  retval = NULL_TREE;
+  ret_type = TREE_TYPE (DECL_RESULT (current_function_decl));
+  if (!VOID_TYPE_P (ret_type))
+    {
+      retval = create_tmp_reg (ret_type, "tsan_ret");
+      add_referenced_var (retval);
+      retval = make_ssa_name (retval, call);
+      gimple_call_set_lhs (call, retval);
+    }
+  gimple_seq_add_stmt (&seq, call);
+  gimple_seq_add_stmt (&seq, gimple_build_return (retval));
+  set_location (seq, cfun->function_start_locus);
+  gsi = gsi_start_bb (call_bb);
+  gsi_insert_seq_after (&gsi, seq, GSI_NEW_STMT);
+
+  free_dominance_info (CDI_DOMINATORS);
+  tsan_stats.cloned_funcs += 1;
+  tsan_stats.cloned_mops += func_mops;
+}
+
 /* ThreadSanitizer instrumentation pass.  */
 
 static unsigned
 tsan_pass (void)
 {
   struct gimplify_ctx gctx;
+  tree clone;
 
+  /* Uninstrumented clones are left as is.  */
+  if (uninst_clones != NULL
+      && pointer_set_contains (uninst_clones, current_function_decl))
+    return 0;
+
+  tsan_stats.funcs += 1;
   func_ignore = tsan_ignore ();
   if (func_ignore == tsan_ignore_func)
-    return 0;
+    {
+      tsan_stats.ignored_funcs += 1;
+      return 0;
+    }
+  tsan_stats.bbs += n_basic_blocks - NUM_FIXED_BLOCKS;
 
   func_calls = 0;
   func_mops = 0;
 
   push_gimplify_context (&gctx);
 
+  clone = NULL_TREE;
+  if (flag_tsan_clones && is_func_clone_required ())
+    clone = build_uninstrumented_clone ();
+
   instrument_mops ();
 
   if (is_func_instrumentation_required ())
@@ -1077,6 +1486,9 @@ tsan_pass (void)
       instrument_func_exit ();
     }
 
+  if (clone != NULL_TREE)
+    instrument_func_dispatch (clone);
+
   pop_gimplify_context (NULL);
 
   return 0;
@@ -1090,12 +1502,33 @@ tsan_gate (void)
   return flag_tsan != 0;
 }
 
+/* Prints per-file instrumentation statistics.  */
+
+static void
+print_stats (void)
+{
+  fprintf (stderr, "tsan: instrumentation stats for %s\n",
+           main_input_filename);
+  fprintf (stderr, "  functions: %d (%d ignored)\n",
+           tsan_stats.funcs, tsan_stats.ignored_funcs);
+  fprintf (stderr, "  basic blocks: %d\n", tsan_stats.bbs);
+  fprintf (stderr, "  memory accesses: %d\n", tsan_stats.mops);
+  fprintf (stderr, "  instrumented accesses: %d\n", tsan_stats.inst_mops);
+  fprintf (stderr, "  redundant accesses: %d\n", tsan_stats.redundant_mops);
+  fprintf (stderr, "  merged field accesses: %d\n", tsan_stats.merged_mops);
+  fprintf (stderr, "  uninstrumented clones: %d (%d accesses)\n",
+           tsan_stats.cloned_funcs, tsan_stats.cloned_mops);
+}
+
 /* Inserts __tsan_init () into the list of CTORs.  */
 
 void tsan_finish_file (void)
 {
   tree ctor_statements;
 
+  if (flag_tsan_stats)
+    print_stats ();
+
   ctor_statements = NULL_TREE;
   append_to_statement_list (build_call_expr (get_init_decl (), 0),
                             &ctor_statements);
@@ -55,6 +55,8 @@ int plugin_is_GPL_compatible = 1;
 extern struct gimple_opt_pass pass_tsan;
 int flag_tsan;
 const char *flag_tsan_ignore;
+int flag_tsan_stats;
+int flag_tsan_clones;
 
 #if 1
 static void
@@ -90,6 +92,10 @@ plugin_init (struct plugin_name_args* info, struct plugin_gcc_version* ver)
     {
       if (strcmp (info->argv[i].key, "ignore") == 0)
         flag_tsan_ignore = xstrdup (info->argv[i].value);
+      else if (strcmp (info->argv[i].key, "stats") == 0)
+        flag_tsan_stats = 1;
+      else if (strcmp (info->argv[i].key, "clones") == 0)
+        flag_tsan_clones = 1;
     }
 
   pass.pass = &pass_tsan.pass;
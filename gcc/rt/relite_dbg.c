@@ -64,6 +64,7 @@ void                    relite_fatal        (char const* fmt, ...) {
   va_end(argptr);
 
   write(1, buf2, strlen(buf2));
+  // exit() prints the pending reports (see relite_report_init()).
   exit(1);
 }
 
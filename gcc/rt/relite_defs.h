@@ -33,6 +33,12 @@
 //#define RELITE_API_AMBUSH
 #define RELITE_SCHED_SHAKE
 
+// Number of shadow cells per 8-byte granule (see handle_access_cells()).
+// With 1 cell only the last access to each address is remembered.
+#ifndef RELITE_SHADOW_CELLS
+#define RELITE_SHADOW_CELLS     1
+#endif
+
 
 typedef                 void const volatile*addr_t;
 typedef                 uint32_t            thrid_t;
@@ -51,7 +57,13 @@ typedef                 uint64_t            state_t;
 #define STATE_SIZE_SHIFT        61
 #define STATE_LOAD_MASK         0x1000000000000000ull
 #define STATE_LOAD_SHIFT        60
+#if RELITE_SHADOW_CELLS > 1
+#define STATE_OFFSET_MASK       0x0E00000000000000ull
+#define STATE_OFFSET_SHIFT      57
+#define STATE_THRID_MASK        0x01FFF00000000000ull
+#else
 #define STATE_THRID_MASK        0x0FFFF00000000000ull
+#endif
 #define STATE_THRID_SHIFT       44
 #define STATE_TIMESTAMP_MASK    0x00000FFFFFFFFFFFull
 
@@ -64,6 +76,15 @@ typedef                 uint64_t            state_t;
 #define SZ_4                    1
 #define SZ_8                    0
 
+#if RELITE_SHADOW_CELLS > 1
+#if RELITE_SHADOW_CELLS > 8
+#error "a granule has only 8 shadow words"
+#endif
+#if MAX_THREADS > (1 << 13)
+#error "thread index does not fit into a shadow cell"
+#endif
+#endif
+
 
 #endif
 
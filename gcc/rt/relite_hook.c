@@ -75,6 +75,8 @@ static relite_hook_t hooks [] = {
   {relite_hook_memcpy,                  "memcpy",                 lib_libc},
   {relite_hook_memcmp,                  "memcmp",                 lib_libc},
 
+  {relite_hook__exit,                   "_exit",                  lib_libc},
+
   {relite_hook_pthread_create,          "pthread_create",         lib_pthread},
   {relite_hook_pthread_join,            "pthread_join",           lib_pthread},
   {relite_hook_pthread_mutex_init,      "pthread_mutex_init",     lib_pthread},
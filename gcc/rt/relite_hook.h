@@ -42,6 +42,8 @@ typedef enum relite_hook_e {
   relite_hook_memcpy,
   relite_hook_memcmp,
 
+  relite_hook__exit,
+
   relite_hook_pthread_create,
   relite_hook_pthread_join,
 
@@ -31,6 +31,7 @@
 #include "relite_rt.h"
 #include "relite_rt_int.h"
 #include <pthread.h>
+#include <signal.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -47,6 +48,17 @@
 #include "libiberty.h"
 
 #define RELITE_PRINT_STACK
+// Keep reports in memory and symbolize/print them at exit, _exit(),
+// on a fatal signal (or when relite_report_flush() is called),
+// so that the racing thread does not wait for BFD.
+#define RELITE_DEFER_SYMBOLIZATION
+
+#define MAX_REPORT_FRAMES                   64
+#define MAX_PENDING_REPORTS                 256
+#define REPORT_DEDUP_SIZE                   4096
+#define REPORT_DEDUP_PROBES                 16
+#define SYM_CACHE_SIZE                      4096
+#define REPORT_RING_SIZE                    1024
 
 
 typedef struct libtrace_data_t {
@@ -78,14 +90,77 @@ static libtrace_data_t g_libtrace_data = {
 };
 
 
+typedef struct pending_report_t {
+  relite_report_t                           report;
+  int                                       stack_size;
+  void*                                     stack [MAX_REPORT_FRAMES];
+} pending_report_t;
+
+
+typedef struct sym_cache_entry_t {
+  void*                                     pc;
+  char*                                     func;
+  char*                                     file;
+} sym_cache_entry_t;
+
+
+// Hashes of the reports printed so far, used for deduplication.
+static atomic_uint64_t  g_report_dedup [REPORT_DEDUP_SIZE];
+static atomic_uint64_t  g_report_dup_count;
+// Both are protected by g_libtrace_data.mtx.
+static pending_report_t g_pending_reports [MAX_PENDING_REPORTS];
+static int              g_pending_count;
+static sym_cache_entry_t g_sym_cache [SYM_CACHE_SIZE];
+
+
+// Bounded MPMC queue: a cell is free for the producer at position pos
+// when its seq == pos, and holds a record for the consumer when
+// seq == pos + 1.
+typedef struct report_cell_t {
+  atomic_uint64_t                           seq;
+  relite_report_rec_t                       rec;
+} report_cell_t;
+
+
+static report_cell_t    g_report_ring [REPORT_RING_SIZE];
+static atomic_uint64_t  g_report_ring_enqueue __attribute__((aligned(64)));
+static atomic_uint64_t  g_report_ring_dequeue __attribute__((aligned(64)));
+static atomic_uint64_t  g_report_ring_dropped;
+static int volatile     g_report_ring_enabled;
+static char*            g_report_dump_file;
+// The process that initialized the reports, see relite_report_exit_flush().
+static pid_t            g_report_pid;
+
+static void             report_ring_dump    ();
+
+
 typedef int(*report_hook_f)(relite_report_t const*);
 static report_hook_f volatile g_report_hook;
 
+static int const        g_fatal_signals [] = {
+    SIGSEGV, SIGBUS, SIGILL, SIGFPE, SIGABRT};
+static struct sigaction g_prev_actions [sizeof(g_fatal_signals)
+                                        / sizeof(g_fatal_signals[0])];
+
 void                    relite_report_hook  (report_hook_f hook) {
   g_report_hook = hook;
 }
 
 
+// Prints the pending reports before the process dies of a signal.
+// Not async-signal-safe, but the process is going down anyway.
+static void             report_on_signal    (int sig) {
+  relite_report_flush();
+  fflush(stdout);
+  size_t i;
+  for (i = 0; i != sizeof(g_fatal_signals)/sizeof(g_fatal_signals[0]); i += 1) {
+    if (g_fatal_signals[i] == sig)
+      sigaction(sig, &g_prev_actions[i], 0);
+  }
+  raise(sig);
+}
+
+
 void                    relite_report_init  () {
   FILE* cmdline = fopen("/proc/self/cmdline", "rb");
   if (cmdline == 0)
@@ -94,6 +169,7 @@ void                    relite_report_init  () {
   if (fread(buf, 1, sizeof(buf)/sizeof(buf[0]) - 1, cmdline) <= 0)
     relite_fatal("failed to read /proc/self/cmdline (%d)", errno);
   fclose(cmdline);
+  g_report_pid = getpid();
 
   bfd_init();
   bfd* abfd = bfd_openr(buf, 0);
@@ -116,6 +192,135 @@ void                    relite_report_init  () {
   if (symcount < 0)
     relite_fatal("bfd_read_minisymbols() failed");
   g_libtrace_data.syms = syms;
+  size_t i;
+  atexit(relite_report_flush);
+#ifdef RELITE_DEFER_SYMBOLIZATION
+  struct sigaction act;
+  memset(&act, 0, sizeof(act));
+  act.sa_handler = report_on_signal;
+  sigemptyset(&act.sa_mask);
+  act.sa_flags = SA_RESETHAND | SA_NODEFER;
+  for (i = 0; i != sizeof(g_fatal_signals)/sizeof(g_fatal_signals[0]); i += 1)
+    sigaction(g_fatal_signals[i], &act, &g_prev_actions[i]);
+#endif
+
+  for (i = 0; i != REPORT_RING_SIZE; i += 1)
+    atomic_uint64_store(&g_report_ring[i].seq, i, memory_order_relaxed);
+  char const* dump_file = getenv("RELITE_REPORT_DUMP");
+  if (dump_file != 0 && dump_file[0] != 0) {
+    g_report_dump_file = strdup(dump_file);
+    g_report_ring_enabled = 1;
+    atexit(report_ring_dump);
+  }
+}
+
+
+void                    relite_report_ring  (int enable) {
+  // the reports seen before are put into the newly enabled ring again
+  if (enable && g_report_ring_enabled == 0) {
+    size_t i;
+    for (i = 0; i != REPORT_DEDUP_SIZE; i += 1)
+      atomic_uint64_store(&g_report_dedup[i], 0, memory_order_relaxed);
+  }
+  g_report_ring_enabled = enable;
+}
+
+
+static void             report_ring_push    (relite_report_t const* report,
+                                             state_t state,
+                                             int is_load,
+                                             void* const* stack,
+                                             int stack_size) {
+  report_cell_t* cell;
+  uint64_t pos = atomic_uint64_load(&g_report_ring_enqueue,
+                                    memory_order_relaxed);
+  for (;;) {
+    cell = &g_report_ring[pos % REPORT_RING_SIZE];
+    uint64_t const seq = atomic_uint64_load(&cell->seq, memory_order_acquire);
+    int64_t const dif = (int64_t)(seq - pos);
+    if (dif == 0) {
+      if (atomic_uint64_compare_exchange(&g_report_ring_enqueue, &pos, pos + 1,
+                                         memory_order_relaxed))
+        break;
+    } else if (dif < 0) {
+      atomic_uint64_fetch_add(&g_report_ring_dropped, 1, memory_order_relaxed);
+      return;
+    } else {
+      pos = atomic_uint64_load(&g_report_ring_enqueue, memory_order_relaxed);
+    }
+  }
+
+  relite_report_rec_t* rec = &cell->rec;
+  rec->addr = (uintptr_t)report->addr;
+  rec->state = state;
+  rec->type = report->type;
+  rec->size = report->size;
+  rec->is_load = is_load;
+  if (stack_size > RELITE_REPORT_PCS)
+    stack_size = RELITE_REPORT_PCS;
+  rec->stack_size = stack_size;
+  int i;
+  for (i = 0; i != stack_size; i += 1)
+    rec->stack[i] = (uintptr_t)stack[i];
+  atomic_uint64_store(&cell->seq, pos + 1, memory_order_release);
+}
+
+
+int                     relite_report_drain (relite_report_rec_t* recs,
+                                             int count) {
+  int n;
+  for (n = 0; n != count; n += 1) {
+    report_cell_t* cell;
+    uint64_t pos = atomic_uint64_load(&g_report_ring_dequeue,
+                                      memory_order_relaxed);
+    for (;;) {
+      cell = &g_report_ring[pos % REPORT_RING_SIZE];
+      uint64_t const seq = atomic_uint64_load(&cell->seq,
+                                              memory_order_acquire);
+      int64_t const dif = (int64_t)(seq - (pos + 1));
+      if (dif == 0) {
+        if (atomic_uint64_compare_exchange(&g_report_ring_dequeue, &pos,
+                                           pos + 1, memory_order_relaxed))
+          break;
+      } else if (dif < 0) {
+        return n;
+      } else {
+        pos = atomic_uint64_load(&g_report_ring_dequeue, memory_order_relaxed);
+      }
+    }
+    recs[n] = cell->rec;
+    atomic_uint64_store(&cell->seq, pos + REPORT_RING_SIZE,
+                        memory_order_release);
+  }
+  return n;
+}
+
+
+uint64_t                relite_report_dropped () {
+  return atomic_uint64_load(&g_report_ring_dropped, memory_order_relaxed);
+}
+
+
+// Writes the reports left in the ring into RELITE_REPORT_DUMP file.
+static void             report_ring_dump    () {
+  FILE* f = fopen(g_report_dump_file, "wb");
+  if (f == 0) {
+    fprintf(stderr, "relite: failed to open report dump file '%s' (%d)\n",
+            g_report_dump_file, errno);
+    return;
+  }
+  relite_report_dump_hdr_t hdr = {};
+  memcpy(hdr.magic, RELITE_REPORT_DUMP_MAGIC, sizeof(hdr.magic));
+  hdr.rec_size = sizeof(relite_report_rec_t);
+  fwrite(&hdr, sizeof(hdr), 1, f);
+  relite_report_rec_t recs [64];
+  int n;
+  while ((n = relite_report_drain(recs, sizeof(recs)/sizeof(recs[0]))) != 0)
+    hdr.count += fwrite(recs, sizeof(recs[0]), n, f);
+  hdr.dropped = relite_report_dropped();
+  fseek(f, 0, SEEK_SET);
+  fwrite(&hdr, sizeof(hdr), 1, f);
+  fclose(f);
 }
 
 
@@ -205,6 +410,114 @@ static void             translate_addresses (bfd* abfd,
 }
 
 
+// Same as translate_addresses(), but caches the result for the pc.
+static void             symbolize_pc        (void* pc,
+                                             char const** func,
+                                             char const** file) {
+  static char buf_func [PATH_MAX + 1];
+  static char buf_file [PATH_MAX + 1];
+  size_t const h = ((uintptr_t)pc >> 2) * 2654435761u;
+  size_t i;
+  for (i = 0; i != REPORT_DEDUP_PROBES; i += 1) {
+    sym_cache_entry_t* e = &g_sym_cache[(h + i) % SYM_CACHE_SIZE];
+    if (e->pc == pc) {
+      *func = e->func;
+      *file = e->file;
+      return;
+    }
+    if (e->pc == 0) {
+      translate_addresses(g_libtrace_data.abfd, pc,
+                          buf_func, sizeof(buf_func)/sizeof(buf_func[0]) - 1,
+                          buf_file, sizeof(buf_file)/sizeof(buf_file[0]) - 1);
+      e->func = strdup(buf_func);
+      e->file = strdup(buf_file);
+      if (e->func == 0 || e->file == 0)
+        break;
+      e->pc = pc;
+      *func = e->func;
+      *file = e->file;
+      return;
+    }
+  }
+  // the cache is full around this pc
+  translate_addresses(g_libtrace_data.abfd, pc,
+                      buf_func, sizeof(buf_func)/sizeof(buf_func[0]) - 1,
+                      buf_file, sizeof(buf_file)/sizeof(buf_file[0]) - 1);
+  *func = buf_func;
+  *file = buf_file;
+}
+
+
+static void             print_report        (FILE* out,
+                                             pending_report_t const* r) {
+#ifdef RELITE_PRINT_STACK
+  fprintf(out, "\n--------------------------------\n");
+#endif
+  fprintf(out, "%s on %p (%u bytes)\n",
+          relite_report_str(r->report.type),
+          r->report.addr,
+          r->report.size);
+
+#ifdef RELITE_PRINT_STACK
+  int i;
+  int pos = 0;
+  for (i = 0; i != r->stack_size; i += 1) {
+    char const* func;
+    char const* file;
+    symbolize_pc(r->stack[i], &func, &file);
+    if (strcmp(func, "relite_thread_wrapper()") == 0)
+      break;
+    if (strncmp(func, "relite_", sizeof("relite_") - 1) == 0)
+      continue;
+    fprintf(out, "  #%d %s, %s\n",
+            pos, func, file);
+    pos += 1;
+    if (strcmp(func, "main()") == 0)
+      break;
+  }
+  fprintf(out, "--------------------------------\n\n");
+#endif
+}
+
+
+static void             flush_locked        () {
+  int i;
+  for (i = 0; i != g_pending_count; i += 1)
+    print_report(stdout, &g_pending_reports[i]);
+  g_pending_count = 0;
+  fflush(stdout);
+}
+
+
+// Returns 1 if a report with the same hash was already seen,
+// otherwise remembers it.
+static int              report_is_duplicate (uint64_t hash) {
+  size_t i;
+  for (i = 0; i != REPORT_DEDUP_PROBES; i += 1) {
+    atomic_uint64_t* slot = &g_report_dedup[(hash + i) % REPORT_DEDUP_SIZE];
+    uint64_t cmp = atomic_uint64_load(slot, memory_order_relaxed);
+    if (cmp == 0 && atomic_uint64_compare_exchange(slot, &cmp, hash,
+                                                   memory_order_relaxed))
+      return 0;
+    if (cmp == hash)
+      return 1;
+  }
+  // the table is full around this hash, do not suppress
+  return 0;
+}
+
+
+static uint64_t         report_hash         (relite_report_t const* report,
+                                             void* const* stack,
+                                             int stack_size) {
+  uint64_t h = 14695981039346656037ull + report->type;
+  int i;
+  for (i = 0; i != stack_size; i += 1)
+    h = (h ^ (uintptr_t)stack[i]) * 1099511628211ull;
+  return h | 1;
+}
+
+
 void                    relite_report       (addr_t addr,
                                              state_t state,
                                              int is_load) {
@@ -243,44 +556,69 @@ void                    relite_report       (addr_t addr,
     my_tid = 1;
   if (atomic_uint32_load(&g_libtrace_data.mtx, memory_order_relaxed) == my_tid)
     return;
+
+  // reports with the same type and stack are printed only once
+  void* stack [MAX_REPORT_FRAMES];
+  int stack_size = 0;
+#ifdef RELITE_PRINT_STACK
+  stack_size = backtrace(stack, sizeof(stack)/sizeof(stack[0]));
+#endif
+  if (report_is_duplicate(report_hash(&report, stack, stack_size))) {
+    atomic_uint64_fetch_add(&g_report_dup_count, 1, memory_order_relaxed);
+    return;
+  }
+  // a hot racy loop must not fill the ring with copies of one report
+  if (g_report_ring_enabled) {
+    report_ring_push(&report, state, is_load, stack, stack_size);
+    return;
+  }
+
   while (atomic_uint32_exchange
       (&g_libtrace_data.mtx, my_tid, memory_order_acquire) != 0)
     sched_yield();
 
-  FILE* out = stdout;
-#ifdef RELITE_PRINT_STACK
-  fprintf(out, "\n--------------------------------\n");
+  if (g_pending_count == MAX_PENDING_REPORTS)
+    flush_locked();
+  pending_report_t* r = &g_pending_reports[g_pending_count++];
+  r->report = report;
+  r->stack_size = stack_size;
+  memcpy(r->stack, stack, stack_size * sizeof(stack[0]));
+#ifndef RELITE_DEFER_SYMBOLIZATION
+  flush_locked();
 #endif
-  fprintf(out, "%s on %p (%u bytes)\n",
-          relite_report_str(report.type),
-          addr,
-          report.size);
 
-#ifdef RELITE_PRINT_STACK
-  void* stacktrace [64];
-  int stacktrace_size = backtrace(
-      stacktrace, sizeof(stacktrace)/sizeof(stacktrace[0]));
-  int i;
-  int pos = 0;
-  for (i = 0; i != stacktrace_size; i += 1) {
-    char buf_func [PATH_MAX + 1];
-    char buf_file [PATH_MAX + 1];
-    translate_addresses(g_libtrace_data.abfd,
-                        stacktrace[i],
-                        buf_func, sizeof(buf_func)/sizeof(buf_func[0]) - 1,
-                        buf_file, sizeof(buf_file)/sizeof(buf_file[0]) - 1);
-    if (strcmp(buf_func, "relite_thread_wrapper()") == 0)
-      break;
-    if (strncmp(buf_func, "relite_", sizeof("relite_") - 1) == 0)
-      continue;
-    fprintf(out, "  #%d %s, %s\n",
-            pos, buf_func, buf_file);
-    pos += 1;
-    if (strcmp(buf_func, "main()") == 0)
-      break;
+  atomic_uint32_store(&g_libtrace_data.mtx, 0, memory_order_release);
+}
+
+
+// A forked child holds a copy of the pending reports of its parent,
+// and a vfork child shares the memory of the parent (flushing would
+// empty the pending list under it), so only the process that initialized
+// the reports flushes them at _exit().
+void                    relite_report_exit_flush () {
+  if (getpid() == g_report_pid)
+    relite_report_flush();
+}
+
+
+void                    relite_report_flush () {
+  unsigned my_tid = (unsigned)pthread_self();
+  if (my_tid == 0)
+    my_tid = 1;
+  if (atomic_uint32_load(&g_libtrace_data.mtx, memory_order_relaxed) == my_tid)
+    return;
+  while (atomic_uint32_exchange
+      (&g_libtrace_data.mtx, my_tid, memory_order_acquire) != 0)
+    sched_yield();
+
+  flush_locked();
+  uint64_t const dup_count = atomic_uint64_load(&g_report_dup_count,
+                                                memory_order_relaxed);
+  if (dup_count != 0) {
+    fprintf(stdout, "relite: %llu duplicate reports suppressed\n",
+            (unsigned long long)dup_count);
+    atomic_uint64_store(&g_report_dup_count, 0, memory_order_relaxed);
   }
-  fprintf(out, "--------------------------------\n\n");
-#endif
 
   atomic_uint32_store(&g_libtrace_data.mtx, 0, memory_order_release);
 }
@@ -34,6 +34,11 @@
 void                    relite_report_init  ();
 
 
+// Called from _exit(): flushes the pending reports in the process
+// that initialized them only.
+void                    relite_report_exit_flush ();
+
+
 void                    relite_report       (addr_t addr,
                                              state_t state,
                                              int is_load);
@@ -60,6 +60,10 @@
 //    L == 0 -> store
 // ----TTTT TTTTTTTT TTTT---- -------- -------- -------- -------- --------
 //    T - thread index (16 bits)
+// ----OOOT TTTTTTTT TTTT---- -------- -------- -------- -------- --------
+//    with RELITE_SHADOW_CELLS > 1:
+//    O - offset of the accessed byte in the granule (for SZ == 3)
+//    T - thread index (13 bits)
 // -------- -------- ----CCCC CCCCCCCC CCCCCCCC CCCCCCCC CCCCCCCC CCCCCCCC
 //    C - timestamp (clock) (44 bits)
 
@@ -139,7 +143,8 @@ void handle_thread_start () {
 void                    handle_thread_end () {
   assert(g_thr != 0);
   relite_thr_t* thr = g_thr;
-  DBG("thread end %u", thr->id);
+  DBG("thread end %u (clock cache misses: %llu)",
+      thr->id, (unsigned long long)thr->clock_cache_misses);
   relite_thr_free(thr);
 }
 
@@ -212,14 +217,6 @@ static inline atomic_uint64_t* get_shadow(addr_t addr) {
 }
 
 
-static void   clock_assign_max    (timestamp_t* dest, timestamp_t const* src) {
-  int i;
-  for (i = 0; i != MAX_THREADS; i += 1) {
-    if (dest[i] < src[i])
-      dest[i] = src[i];
-  }
-}
-
 /*
 static int is_aligned(uintptr_t addr, size_t sz) {
   return ((addr & ((1 << (3 - sz)) - 1)) == 0);
@@ -343,7 +340,97 @@ static NOINLINE void handle_store_slow(atomic_uint64_t* shadow,
 
 
 
+#if RELITE_SHADOW_CELLS > 1
+// The 8 shadow words of a granule hold up to RELITE_SHADOW_CELLS recent
+// accesses to it, so that e.g. a store is checked against all preceding
+// loads from different threads and not only against the last one.
+// A cell written here has SZ_1 and the offset of the accessed byte;
+// a cell with another size or a special timestamp (written by the memory
+// handlers) covers the whole granule. The region handlers keep the size
+// and the offset of the cells they rewrite (see REGION_KEPT_MASK).
+// A cell is replaced if it belongs to the same thread, or if it happens
+// before the current access; otherwise a pseudo-random one is evicted.
+static inline int cell_covers(uint64_t cell, uint64_t offset_bits) {
+  if ((cell & STATE_SIZE_MASK) != ((uint64_t)SZ_1 << STATE_SIZE_SHIFT))
+    return 1;
+  if ((cell & STATE_TIMESTAMP_MASK) >= STATE_FREED)
+    return 1;
+  return (cell & STATE_OFFSET_MASK) == offset_bits;
+}
+
+
+static inline void handle_access_cells(addr_t addr, int is_load) {
+  assert(addr != 0);
+  atomic_uint64_t* shadow = get_shadow(addr);
+  uint64_t const own = atomic_uint64_load(shadow, memory_order_relaxed);
+  // ensure that the address was not used as a sync variable
+  if (UNLIKELY((own & STATE_SYNC_MASK) != 0))
+    return;
+  atomic_uint64_t* cells = shadow - ((uintptr_t)addr & 7);
+  relite_thr_t* self = g_thr;
+  uint64_t const offset_bits = ((uint64_t)addr & 7) << STATE_OFFSET_SHIFT;
+  uint64_t const new_state = ((uint64_t)SZ_1 << STATE_SIZE_SHIFT)
+      | offset_bits
+      | (is_load ? STATE_LOAD_MASK : 0)
+      | ((uint64_t)self->id << STATE_THRID_SHIFT)
+      | self->own_clock;
+  // load all cells first, so that the checks below are
+  // a straight loop over a local array
+  uint64_t state [RELITE_SHADOW_CELLS];
+  int i;
+  for (i = 0; i != RELITE_SHADOW_CELLS; i += 1)
+    state[i] = atomic_uint64_load(&cells[i], memory_order_relaxed);
+
+  int is_stored = 0;
+  int is_race_detected = 0;
+  int victim = -1;
+  for (i = 0; i != RELITE_SHADOW_CELLS; i += 1) {
+    uint64_t const s = state[i];
+    if (s == 0) {
+      if (victim < 0)
+        victim = i;
+      continue;
+    }
+    if ((s & STATE_SYNC_MASK) != 0 || cell_covers(s, offset_bits) == 0)
+      continue;
+    size_t const prev_thrid = (s & STATE_THRID_MASK) >> STATE_THRID_SHIFT;
+    if (prev_thrid == self->id) {
+      // a store is not replaced by a load from the same thread
+      if (is_stored == 0 && (is_load == 0 || (s & STATE_LOAD_MASK) != 0)) {
+        if (s != new_state)
+          atomic_uint64_store(&cells[i], new_state, memory_order_relaxed);
+        is_stored = 1;
+      }
+      continue;
+    }
+    // loads do not race with each other
+    if (is_load && (s & STATE_LOAD_MASK) != 0)
+      continue;
+    timestamp_t const prev_ts = (s & STATE_TIMESTAMP_MASK);
+    if (UNLIKELY(prev_ts > relite_thr_clock(self, prev_thrid))) {
+      if (is_race_detected == 0 && (is_load || prev_ts != STATE_UNITIALIZED)) {
+        is_race_detected = 1;
+        relite_report(addr, s, is_load);
+      }
+    } else if (victim < 0) {
+      victim = i;
+    }
+  }
+
+  if (is_stored == 0) {
+    if (victim < 0)
+      victim = relite_thr_rand(self, RELITE_SHADOW_CELLS);
+    if ((state[victim] & STATE_SYNC_MASK) == 0)
+      atomic_uint64_store(&cells[victim], new_state, memory_order_relaxed);
+  }
+}
+#endif
+
+
 void            relite_load    (addr_t addr, unsigned flags) {
+#if RELITE_SHADOW_CELLS > 1
+  handle_access_cells(addr, 1);
+#else
   int sz = 0;
   assert(addr != 0);
   assert(sz < 4);
@@ -366,13 +453,13 @@ void            relite_load    (addr_t addr, unsigned flags) {
           timestamp_t prev_ts = (state & STATE_TIMESTAMP_MASK);
           // check for a race:
           // the previous store should happen before current load
-          if (UNLIKELY(prev_ts > self->clock[prev_thrid])) {
+          if (UNLIKELY(prev_ts > relite_thr_clock(self, prev_thrid))) {
             relite_report(addr, state, 1);
           }
           // calculate and store new state
           uint64_t const new_state = ((uint64_t)sz << STATE_SIZE_SHIFT)
             | STATE_LOAD_MASK | ((uint64_t)self->id << STATE_THRID_SHIFT)
-            | self->clock[self->id];
+            | self->own_clock;
           atomic_uint64_store(shadow, new_state, memory_order_relaxed);
         } else {
           // the previous access was a load,
@@ -384,7 +471,7 @@ void            relite_load    (addr_t addr, unsigned flags) {
         // (if it was a store, then we better preserve the fact)
         if (LIKELY((state & STATE_LOAD_MASK) != 0)) {
           uint64_t const new_state = (state & ~STATE_TIMESTAMP_MASK)
-            | self->clock[self->id];
+            | self->own_clock;
           atomic_uint64_store(shadow, new_state, memory_order_relaxed);
         }
       }
@@ -398,10 +485,14 @@ void            relite_load    (addr_t addr, unsigned flags) {
     // the address was used as a sync variable,
     // so do not track races on it
   }
+#endif
 }
 
 
 void            relite_store   (addr_t addr, unsigned flags) {
+#if RELITE_SHADOW_CELLS > 1
+  handle_access_cells(addr, 0);
+#else
   int sz = 0;
   assert(addr != 0);
   assert(sz < 4);
@@ -423,7 +514,7 @@ void            relite_store   (addr_t addr, unsigned flags) {
       if (UNLIKELY(prev_thrid != self->id)) {
         // check for a race:
         // the previous access should happen before current store
-        if (UNLIKELY(prev_ts > (self->clock[prev_thrid]))) {
+        if (UNLIKELY(prev_ts > relite_thr_clock(self, prev_thrid))) {
           if (UNLIKELY(prev_ts != STATE_UNITIALIZED)) {
             relite_report(addr, state, 0);
           }
@@ -431,14 +522,14 @@ void            relite_store   (addr_t addr, unsigned flags) {
         // calculate and store new state
         uint64_t const volatile new_state = ((uint64_t)sz << STATE_SIZE_SHIFT)
             | ((uint64_t)self->id << STATE_THRID_SHIFT)
-            | self->clock[self->id];
+            | self->own_clock;
         atomic_uint64_store(shadow, new_state, memory_order_relaxed);
       } else {
         if (UNLIKELY(prev_ts != own_clock)) {
           // calculate and store new state
           uint64_t const volatile new_state = ((uint64_t)sz << STATE_SIZE_SHIFT)
             | ((uint64_t)self->id << STATE_THRID_SHIFT)
-            | self->clock[self->id];
+            | self->own_clock;
           atomic_uint64_store(shadow, new_state, memory_order_relaxed);
         }
       }
@@ -452,16 +543,25 @@ void            relite_store   (addr_t addr, unsigned flags) {
     // the address was used as a sync variable,
     // so do not track races on it
   }
+#endif
 }
 
 
+// The bits of a shadow word kept when a region access rewrites it.
+#if RELITE_SHADOW_CELLS > 1
+#define REGION_KEPT_MASK        (STATE_SIZE_MASK | STATE_OFFSET_MASK)
+#else
+#define REGION_KEPT_MASK        STATE_SIZE_MASK
+#endif
+
+
 void                    handle_region_load  (void const volatile* begin,
                                              void const volatile* end) {
   //TODO(dvyukov): properly handle unaligned head and tail of the region
   assert(begin != 0 && begin <= end);
   DBG("checking region load %p-%p", begin, end);
   relite_thr_t* self = g_thr;
-  uint64_t const my_ts = self->clock[self->id];
+  uint64_t const my_ts = self->own_clock;
   uint64_t const state_templ = ((uint64_t)self->id << STATE_THRID_SHIFT)
       | STATE_LOAD_MASK
       | my_ts;
@@ -485,7 +585,7 @@ void                    handle_region_load  (void const volatile* begin,
           if (LIKELY((state & STATE_LOAD_MASK) == 0)) {
             // check for a race:
             // the previous access should happen before current store
-            if (UNLIKELY(prev_ts > (self->clock[prev_thrid]))) {
+            if (UNLIKELY(prev_ts > relite_thr_clock(self, prev_thrid))) {
               if (is_race_detected == 0) {
                 is_race_detected = 1;
                 relite_report(begin + (shadow - get_shadow(begin)), state, 1);
@@ -493,7 +593,7 @@ void                    handle_region_load  (void const volatile* begin,
             }
             // calculate and store new state
             uint64_t const new_state = state_templ
-                | ((uint64_t)real_sz << STATE_SIZE_SHIFT);
+                | (state & REGION_KEPT_MASK);
             atomic_uint64_store(shadow, new_state, memory_order_relaxed);
           } else {
             // the previous access was a load, so do nothing
@@ -525,7 +625,7 @@ void                    handle_region_store (void const volatile* begin,
   assert(begin != 0 && begin <= end);
   DBG("checking region store %p-%p", begin, end);
   relite_thr_t* self = g_thr;
-  uint64_t const my_ts = self->clock[self->id];
+  uint64_t const my_ts = self->own_clock;
   uint64_t const state_templ = ((uint64_t)self->id << STATE_THRID_SHIFT)
       | my_ts;
   int is_race_detected = 0;
@@ -545,7 +645,7 @@ void                    handle_region_store (void const volatile* begin,
           timestamp_t prev_ts = (state & STATE_TIMESTAMP_MASK);
           // check for a race:
           // the previous access should happen before current store
-          if (UNLIKELY(prev_ts > (self->clock[prev_thrid]))) {
+          if (UNLIKELY(prev_ts > relite_thr_clock(self, prev_thrid))) {
             if (UNLIKELY(prev_ts != STATE_UNITIALIZED)) {
               if (is_race_detected == 0) {
                 is_race_detected = 1;
@@ -556,7 +656,7 @@ void                    handle_region_store (void const volatile* begin,
         }
         // calculate and store new state
         uint64_t const new_state = state_templ
-            | ((uint64_t)real_sz << STATE_SIZE_SHIFT);
+            | (state & REGION_KEPT_MASK);
         atomic_uint64_store(shadow, new_state, memory_order_relaxed);
       }
     } else {
@@ -587,7 +687,7 @@ void                    handle_mem_alloc    (addr_t begin,
   relite_thr_t* self = g_thr;
   uint64_t const state_templ = ((uint64_t)SZ_8 << STATE_SIZE_SHIFT)
     | ((uint64_t)self->id << STATE_THRID_SHIFT)
-    | self->clock[self->id];
+    | self->own_clock;
   atomic_uint64_t* shadow = get_shadow(begin);
   atomic_uint64_t* shadow_end = get_shadow(end);
   assert(shadow <= shadow_end);
@@ -617,7 +717,7 @@ void                    handle_mem_free     (addr_t begin,
         size_t prev_thrid = (state & STATE_THRID_MASK) >> STATE_THRID_SHIFT;
         // check for a race:
         // the previous access should happen before current store
-        if (UNLIKELY(prev_ts > (self->clock[prev_thrid]))) {
+        if (UNLIKELY(prev_ts > relite_thr_clock(self, prev_thrid))) {
           if (is_race_detected == 0) {
             is_race_detected = 1;
             relite_report(begin + (shadow - get_shadow(begin)), state, 0);
@@ -670,7 +770,7 @@ void            handle_sync_acquire  (addr_t addr, int is_mtx) {
     return;
   rl_rt_sync_t* sync = (rl_rt_sync_t*)(state & ~STATE_SYNC_MASK);
   relite_thr_t* self = g_thr;
-  clock_assign_max(self->clock, sync->clock);
+  relite_thr_acquire(self, sync->clock);
 }
 
 
@@ -695,8 +795,9 @@ void            handle_sync_release  (addr_t addr, int is_mtx) {
   }
   relite_thr_t* self = g_thr;
   self->own_clock += 1;
-  self->clock[self->id] += 1;
-  clock_assign_max(sync->clock, self->clock);
+  relite_thr_clock_set(self, self->id, self->own_clock);
+  relite_thr_clock_refresh(self);
+  relite_thr_release(self, sync->clock);
 }
 
 
@@ -27,6 +27,7 @@
 
 #ifndef RELITE_RT_H_INCLUDED
 #define RELITE_RT_H_INCLUDED
+#include <stdint.h>
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -81,6 +82,53 @@ char const*             relite_report_str   (relite_report_type_e type);
 
 void                    relite_report_hook  (int(*)(relite_report_t const*));
 
+// Symbolizes and prints the pending reports (done at exit as well).
+void                    relite_report_flush ();
+
+
+#define RELITE_REPORT_PCS                   16
+#define RELITE_REPORT_DUMP_MAGIC            "RLREPRT1"
+
+
+// Raw report as stored in the report ring, not symbolized.
+typedef struct relite_report_rec_t {
+  uint64_t                                  addr;
+  uint64_t                                  state; // shadow state of the
+                                                   // conflicting access
+  uint32_t                                  type;  // relite_report_type_e
+  uint32_t                                  size;
+  uint32_t                                  is_load;
+  uint32_t                                  stack_size;
+  uint64_t                                  stack [RELITE_REPORT_PCS];
+} relite_report_rec_t;
+
+
+// Header of the file written at exit if RELITE_REPORT_DUMP=path is set,
+// followed by 'count' relite_report_rec_t records.
+typedef struct relite_report_dump_hdr_t {
+  char                                      magic [8];
+  uint32_t                                  rec_size;
+  uint32_t                                  pad;
+  uint64_t                                  count;
+  uint64_t                                  dropped;
+} relite_report_dump_hdr_t;
+
+
+// When enabled, reports (that are not handled by the hook) are put
+// into a fixed-size lock-free ring instead of being printed.
+// Duplicates (same type and stack) are not put into the ring;
+// enabling the ring forgets the reports seen so far.
+// Reports that do not fit into the ring are counted as dropped.
+void                    relite_report_ring  (int enable);
+
+// Moves up to 'count' reports from the ring into 'recs',
+// returns the number of moved reports.
+int                     relite_report_drain (relite_report_rec_t* recs,
+                                             int count);
+
+// Returns the number of reports dropped because the ring was full.
+uint64_t                relite_report_dropped ();
+
 
 #ifdef __cplusplus
 }
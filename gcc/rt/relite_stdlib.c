@@ -25,7 +25,9 @@
  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include "relite_rt.h"
 #include "relite_rt_int.h"
+#include "relite_report.h"
 #include "relite_stdlib.h"
 #include "relite_hook.h"
 #include "relite_defs.h"
@@ -269,6 +271,17 @@ void*                   relite_memset       (void* s,
 }
 
 
+// _exit() skips atexit handlers, so print the deferred reports here
+// (but not in a fork or vfork child, see relite_report_exit_flush()).
+void                    _exit               (int status) {
+  typedef void (*real_f)(int status);
+  relite_report_exit_flush();
+  real_f real_exit = (real_f)relite_hook_get(relite_hook__exit);
+  real_exit(status);
+  __builtin_unreachable();
+}
+
+
 
 void* __real_mmap(void *addr, size_t length,
                   int prot, int flags, int fd, off_t offset);
@@ -31,23 +31,23 @@
 #include <sys/mman.h>
 #include <pthread.h>
 #include <time.h>
-#include <sched.h>
 
 
+// A freed descriptor is not reused until THREAD_DEFER_COUNT
+// other descriptors are freed after it.
 #define THREAD_DEFER_COUNT                  16
-#define LOCKED                              1
-#define UNLOCKED                            0
+#define TAG_SHIFT                           48
+#define PTR_MASK                            ((1ull << TAG_SHIFT) - 1)
 
 
+// Descriptors are never unmapped, so the free list is a plain
+// Treiber stack; the head is a tagged pointer (the tag is bumped
+// on every update to avoid ABA).
 typedef struct relite_thr_cache_t {
-  atomic_uint32_t                           mtx;
-  uint32_t                                  total_count;
-  uint32_t                                  busy_count;
-  relite_thr_t*                             busy_head;
-  relite_thr_t*                             busy_tail;
-  uint32_t                                  free_count;
-  relite_thr_t*                             free_head;
-  relite_thr_t*                             free_tail;
+  atomic_uint64_t                           total_count;
+  atomic_uint64_t                           free_head;
+  atomic_uint64_t                           defer_pos;
+  atomic_uint64_t                           defer [THREAD_DEFER_COUNT];
 } relite_thr_cache_t;
 
 
@@ -56,63 +56,80 @@ __thread relite_thr_t*                      relite_thr_instance;
 __thread thrid_t                            relite_dbg_tid;
 
 
+static void             free_list_push      (relite_thr_cache_t* cache,
+                                             relite_thr_t* thr) {
+  assert(((uintptr_t)thr & ~PTR_MASK) == 0);
+  uint64_t head = atomic_uint64_load(&cache->free_head,
+                                     memory_order_relaxed);
+  for (;;) {
+    thr->next = (relite_thr_t*)(uintptr_t)(head & PTR_MASK);
+    uint64_t const xchg = (((head >> TAG_SHIFT) + 1) << TAG_SHIFT)
+        | (uintptr_t)thr;
+    if (atomic_uint64_compare_exchange(&cache->free_head, &head, xchg,
+                                       memory_order_release))
+      break;
+  }
+}
+
+
+static relite_thr_t*    free_list_pop       (relite_thr_cache_t* cache) {
+  uint64_t head = atomic_uint64_load(&cache->free_head,
+                                     memory_order_acquire);
+  for (;;) {
+    relite_thr_t* thr = (relite_thr_t*)(uintptr_t)(head & PTR_MASK);
+    if (thr == 0)
+      return 0;
+    // thr may be popped concurrently, but it stays mapped,
+    // and then the CAS fails since the tag has changed
+    uint64_t const xchg = (((head >> TAG_SHIFT) + 1) << TAG_SHIFT)
+        | (uintptr_t)thr->next;
+    if (atomic_uint64_compare_exchange(&cache->free_head, &head, xchg,
+                                       memory_order_acquire))
+      return thr;
+  }
+}
+
+
 relite_thr_t*           relite_thr_init     () {
-  relite_thr_t* thr;
   relite_thr_cache_t* cache = &relite_thr_cache;
-  while (atomic_uint32_exchange
-      (&cache->mtx, LOCKED, memory_order_acquire) != UNLOCKED)
-    sched_yield();
-
-  if (cache->free_count > THREAD_DEFER_COUNT) {
-    assert(cache->free_head != 0);
-    assert(cache->free_head->prev != 0);
-    assert(cache->free_head->next == 0);
-    thr = cache->free_head;
-    cache->free_head = cache->free_head->prev;
-    cache->free_head->next = 0;
-    cache->free_count -= 1;
-    int i;
-    for (i = 0; i != MAX_THREADS; i += 1) {
-      thr->clock[i] = 0;
+  relite_thr_t* thr = free_list_pop(cache);
+  if (thr != 0) {
+    // lazily clear the clock
+    thr->clock_epoch += 1;
+    if (thr->clock_epoch == CLOCK_EPOCH_LIMIT) {
+      int i;
+      for (i = 0; i != MAX_THREADS; i += 1) {
+        thr->clock[i] = 0;
+      }
+      thr->clock_epoch = 0;
     }
-  } else if (cache->total_count < MAX_THREADS) {
+    thr->clock_cache_misses = 0;
+  } else {
+    uint64_t const id = atomic_uint64_fetch_add(&cache->total_count, 1,
+                                                memory_order_relaxed);
+    if (id >= MAX_THREADS)
+      relite_fatal("maximum number of threads is reached");
     thr = (relite_thr_t*)mmap(0, sizeof(relite_thr_t),
                                 PROT_READ | PROT_WRITE,
                                 MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
-    if (thr == 0)
+    if (thr == MAP_FAILED)
       relite_fatal("failed to allocate thread descriptor");
-    thr->id = cache->total_count++;
+    thr->id = (thrid_t)id;
     thr->rand = (unsigned)pthread_self() + (unsigned)time(0);
     DBG("thread start %u", thr->id);
-  } else {
-    relite_fatal("maximum number of threads is reached");
   }
-  if (cache->busy_count == 0) {
-    assert(cache->busy_head == 0);
-    assert(cache->busy_tail == 0);
-    thr->next = 0;
-    thr->prev = 0;
-    cache->busy_head = thr;
-    cache->busy_tail = thr;
-  } else {
-    assert(cache->busy_head != 0);
-    assert(cache->busy_tail != 0);
-    thr->prev = 0;
-    thr->next = cache->busy_tail;
-    cache->busy_tail->prev = thr;
-    cache->busy_tail = thr;
-  }
-  cache->busy_count += 1;
-  assert(cache->busy_count + cache->free_count == cache->total_count);
-
-  atomic_uint32_store(&cache->mtx, UNLOCKED, memory_order_release);
 
   assert(thr != 0);
   assert(relite_thr_instance == 0);
   relite_thr_instance = thr;
   relite_dbg_tid = thr->id;
   thr->own_clock += 1;
-  thr->clock[thr->id] = thr->own_clock;
+  relite_thr_clock_set(thr, thr->id, thr->own_clock);
+  int i;
+  for (i = 0; i != CLOCK_CACHE_SIZE; i += 1) {
+    thr->clock_cache[i] = (uint64_t)i << STATE_THRID_SHIFT;
+  }
+  relite_thr_clock_refresh(thr);
   return thr;
 }
 
@@ -120,42 +137,60 @@ relite_thr_t*           relite_thr_init     () {
 void                    relite_thr_free     (relite_thr_t* thr) {
   assert(thr != 0);
   relite_thr_cache_t* cache = &relite_thr_cache;
-  while (atomic_uint32_exchange
-      (&cache->mtx, LOCKED, memory_order_acquire) != UNLOCKED)
-    sched_yield();
-
-  if (thr->prev != 0) {
-    thr->prev->next = thr->next;
-  } else {
-    assert(cache->busy_tail == thr);
-    cache->busy_tail = thr->next;
+  // put the descriptor into the defer ring,
+  // and free the one that was displaced from it
+  uint64_t const pos = atomic_uint64_fetch_add(&cache->defer_pos, 1,
+                                               memory_order_relaxed);
+  atomic_uint64_t* slot = &cache->defer[pos % THREAD_DEFER_COUNT];
+  uint64_t prev = atomic_uint64_load(slot, memory_order_relaxed);
+  while (atomic_uint64_compare_exchange(slot, &prev, (uintptr_t)thr,
+                                        memory_order_acq_rel) == 0) {
   }
-  if (thr->next != 0) {
-    thr->next->prev = thr->prev;
-  } else {
-    assert(cache->busy_head == thr);
-    cache->busy_head = thr->prev;
+  if (prev != 0)
+    free_list_push(cache, (relite_thr_t*)(uintptr_t)prev);
+}
+
+
+void                    relite_thr_acquire  (relite_thr_t* thr,
+                                             timestamp_t const* src) {
+  thrid_t i;
+  for (i = 0; i != MAX_THREADS; i += 1) {
+    if (relite_thr_clock_get(thr, i) < src[i])
+      relite_thr_clock_set(thr, i, src[i]);
   }
-  cache->busy_count -= 1;
-  if (cache->free_count == 0) {
-    assert(cache->free_head == 0);
-    assert(cache->free_tail == 0);
-    thr->next = 0;
-    thr->prev = 0;
-    cache->free_head = thr;
-    cache->free_tail = thr;
-  } else {
-    assert(cache->free_head != 0);
-    assert(cache->free_tail != 0);
-    thr->prev = 0;
-    thr->next = cache->free_tail;
-    cache->free_tail->prev = thr;
-    cache->free_tail = thr;
+  relite_thr_clock_refresh(thr);
+}
+
+
+void                    relite_thr_release  (relite_thr_t* thr,
+                                             timestamp_t* dst) {
+  thrid_t i;
+  for (i = 0; i != MAX_THREADS; i += 1) {
+    timestamp_t const ts = relite_thr_clock_get(thr, i);
+    if (dst[i] < ts)
+      dst[i] = ts;
   }
-  cache->free_count += 1;
-  assert(cache->busy_count + cache->free_count == cache->total_count);
+}
+
 
-  atomic_uint32_store(&cache->mtx, UNLOCKED, memory_order_release);
+timestamp_t             relite_thr_clock_miss (relite_thr_t* thr,
+                                               thrid_t tid) {
+  assert(tid < MAX_THREADS);
+  thr->clock_cache_misses += 1;
+  timestamp_t const ts = relite_thr_clock_get(thr, tid);
+  thr->clock_cache[tid % CLOCK_CACHE_SIZE] =
+      ((uint64_t)tid << STATE_THRID_SHIFT) | ts;
+  return ts;
+}
+
+
+void                    relite_thr_clock_refresh (relite_thr_t* thr) {
+  int i;
+  for (i = 0; i != CLOCK_CACHE_SIZE; i += 1) {
+    thrid_t const tid = thr->clock_cache[i] >> STATE_THRID_SHIFT;
+    thr->clock_cache[i] = ((uint64_t)tid << STATE_THRID_SHIFT)
+        | relite_thr_clock_get(thr, tid);
+  }
 }
 
 
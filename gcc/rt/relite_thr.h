@@ -31,13 +31,32 @@
 #include "relite_defs.h"
 
 
+// Number of entries in the per-thread clock cache,
+// an entry is (thread index << STATE_THRID_SHIFT) | timestamp.
+#define CLOCK_CACHE_SIZE                    8
+
+// An entry of relite_thr_t::clock is
+// (clock epoch << CLOCK_EPOCH_SHIFT) | timestamp;
+// entries from older epochs read as 0, so reusing a descriptor
+// just bumps the epoch instead of clearing the whole clock.
+#define CLOCK_EPOCH_SHIFT                   44
+#define CLOCK_EPOCH_LIMIT                   (1u << 20)
+
+
 typedef struct relite_thr_t {
   struct relite_thr_t*                      next;
-  struct relite_thr_t*                      prev;
   thrid_t                                   id;
   unsigned                                  rand;
   timestamp_t                               own_clock;
-  timestamp_t                               clock [MAX_THREADS];
+  uint32_t                                  clock_epoch;
+  uint64_t                                  clock_cache_misses;
+  // direct-mapped cache of the clock entries of recently seen threads,
+  // so that a race check touches one cache line instead of
+  // a random place in the MAX_THREADS-wide clock
+  uint64_t                                  clock_cache [CLOCK_CACHE_SIZE]
+                                            __attribute__((aligned(64)));
+  // never accessed directly, see relite_thr_clock_get/set
+  uint64_t                                  clock [MAX_THREADS];
 } relite_thr_t;
 
 
@@ -47,5 +66,41 @@ void                    relite_thr_free     (relite_thr_t* thr);
 unsigned                relite_thr_rand     (relite_thr_t* thr,
                                              unsigned limit);
 
+// thr->clock[i] = max(thr->clock[i], src[i])
+void                    relite_thr_acquire  (relite_thr_t* thr,
+                                             timestamp_t const* src);
+
+// dst[i] = max(dst[i], thr->clock[i])
+void                    relite_thr_release  (relite_thr_t* thr,
+                                             timestamp_t* dst);
+
+timestamp_t             relite_thr_clock_miss (relite_thr_t* thr,
+                                               thrid_t tid);
+
+// must be called whenever thr->clock changes
+void                    relite_thr_clock_refresh (relite_thr_t* thr);
+
+static inline timestamp_t relite_thr_clock_get (relite_thr_t* thr,
+                                                thrid_t tid) {
+  uint64_t const entry = thr->clock[tid];
+  if ((entry >> CLOCK_EPOCH_SHIFT) != thr->clock_epoch)
+    return 0;
+  return entry & STATE_TIMESTAMP_MASK;
+}
+
+static inline void relite_thr_clock_set (relite_thr_t* thr,
+                                         thrid_t tid,
+                                         timestamp_t ts) {
+  thr->clock[tid] = ((uint64_t)thr->clock_epoch << CLOCK_EPOCH_SHIFT) | ts;
+}
+
+static inline timestamp_t relite_thr_clock  (relite_thr_t* thr,
+                                             thrid_t tid) {
+  uint64_t const entry = thr->clock_cache[tid % CLOCK_CACHE_SIZE];
+  if (__builtin_expect((entry >> STATE_THRID_SHIFT) == tid, 1))
+    return entry & STATE_TIMESTAMP_MASK;
+  return relite_thr_clock_miss(thr, tid);
+}
+
 #endif
 
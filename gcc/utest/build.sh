@@ -1,4 +1,14 @@
 ${GCCTSAN_GCC_BIN} -c -fno-inline -fno-exceptions -fplugin=../plg/Debug/librelite.so -include../rt/relite_rt.h main.cc
 ${GCCTSAN_GCC_BIN} -o test -lpthread -lstdc++ -L../rt/Debug -lrelitert main.o
+${GCCTSAN_GCC_BIN} -c -fno-inline -fno-exceptions -fplugin=../plg/Debug/librelite.so -include../rt/relite_rt.h thread_bench.cc
+${GCCTSAN_GCC_BIN} -o thread_bench -lpthread -lstdc++ -L../rt/Debug -lrelitert thread_bench.o
+${GCCTSAN_GCC_BIN} -c -fno-inline -fno-exceptions -fplugin=../plg/Debug/librelite.so -include../rt/relite_rt.h report_ring.cc
+${GCCTSAN_GCC_BIN} -o report_ring -lpthread -lstdc++ -L../rt/Debug -lrelitert report_ring.o
+${GCCTSAN_GCC_BIN} -c -fno-inline -fno-exceptions -fplugin=../plg/Debug/librelite.so -include../rt/relite_rt.h -DRELITE_SHADOW_CELLS=4 shadow_cells.cc
+${GCCTSAN_GCC_BIN} -o shadow_cells -std=gnu99 -DRELITE_SHADOW_CELLS=4 shadow_cells.o ../rt/*.c -lpthread -lstdc++ -ldl -lbfd
+${GCCTSAN_GCC_BIN} -c -fno-inline -fno-exceptions -fplugin=../plg/Debug/librelite.so -include../rt/relite_rt.h -o shadow_cells_1.o shadow_cells.cc
+${GCCTSAN_GCC_BIN} -o shadow_cells_1 -lpthread -lstdc++ -L../rt/Debug -lrelitert shadow_cells_1.o
 
 
+GCCTSAN_ARGS="-fplugin-arg-libtsan_${GCCTSAN_GCC_VER}-clones" ../scripts/g++ -c func_dispatch.cc
+../scripts/g++ -o func_dispatch func_dispatch.o
@@ -0,0 +1,134 @@
+/* Relite
+ * Copyright (c) 2011, Google Inc.
+ * All rights reserved.
+ * Author: Dmitry Vyukov (dvyukov)
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ *     * Neither the name of Google Inc. nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+// Function dispatch test, built with -fplugin-arg-libtsan_<ver>-clones
+// (see instrument_func_dispatch() in tree-tsan.c) and run with the
+// ThreadSanitizer run-time library. racy_disabled() is listed in
+// func_dispatch.ignore, so its calls must go to the uninstrumented clone
+// and its race must not be reported; the same race in racy_enabled()
+// must be reported.
+// Usage: TSAN_ARGS="--ignore=func_dispatch.ignore" func_dispatch
+
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+// Must match TsanFuncDesc in tsan_rtl.cc.
+struct TsanFuncDesc {
+  void* func;
+  uintptr_t enabled;
+  uintptr_t mops;
+  uintptr_t uninst_calls;
+};
+
+extern TsanFuncDesc __start___tsan_funcs[] __attribute__((weak));
+extern TsanFuncDesc __stop___tsan_funcs[] __attribute__((weak));
+extern "C" const char* ThreadSanitizerQuery(const char* query);
+
+static int g_disabled_var;
+static int g_enabled_var;
+
+extern "C" void racy_disabled() {
+  g_disabled_var += 1;
+}
+
+extern "C" void racy_enabled() {
+  g_enabled_var += 1;
+}
+
+static void* disabled_thread(void*) {
+  racy_disabled();
+  return 0;
+}
+
+static void* enabled_thread(void*) {
+  racy_enabled();
+  return 0;
+}
+
+// Runs FUNC in two unsynchronized threads,
+// returns the number of the races reported meanwhile.
+static int run_racy_pair(void* (*func)(void*)) {
+  int const before = atoi(ThreadSanitizerQuery("n_reports"));
+  pthread_t t1, t2;
+  pthread_create(&t1, 0, func, 0);
+  pthread_create(&t2, 0, func, 0);
+  pthread_join(t1, 0);
+  pthread_join(t2, 0);
+  return atoi(ThreadSanitizerQuery("n_reports")) - before;
+}
+
+static TsanFuncDesc* find_desc(void (*func)()) {
+  for (TsanFuncDesc* desc = __start___tsan_funcs;
+       desc != __stop___tsan_funcs; desc += 1) {
+    if (desc->func == (void*)func)
+      return desc;
+  }
+  return 0;
+}
+
+int main() {
+  bool ok = true;
+  TsanFuncDesc* disabled_desc = find_desc(racy_disabled);
+  TsanFuncDesc* enabled_desc = find_desc(racy_enabled);
+  if (disabled_desc == 0 || enabled_desc == 0) {
+    printf("no function descriptors, not built with clones\n");
+    ok = false;
+  } else if (disabled_desc->enabled || !enabled_desc->enabled) {
+    printf("racy_disabled is %s, racy_enabled is %s, "
+           "is func_dispatch.ignore passed in TSAN_ARGS?\n",
+           disabled_desc->enabled ? "enabled" : "disabled",
+           enabled_desc->enabled ? "enabled" : "disabled");
+    ok = false;
+  }
+
+  int const disabled_races = run_racy_pair(disabled_thread);
+  if (disabled_races != 0) {
+    printf("%d races reported in the disabled function\n", disabled_races);
+    ok = false;
+  }
+  // The counter is not atomic, so one of the two calls may be lost.
+  if (disabled_desc != 0 && disabled_desc->uninst_calls == 0) {
+    printf("the uninstrumented clone is not called\n");
+    ok = false;
+  }
+
+  int const enabled_races = run_racy_pair(enabled_thread);
+  if (enabled_races == 0) {
+    printf("the race in the enabled function is not reported\n");
+    ok = false;
+  }
+  if (enabled_desc != 0 && enabled_desc->uninst_calls != 0) {
+    printf("the enabled function called its uninstrumented clone\n");
+    ok = false;
+  }
+
+  printf("func_dispatch: %s\n", ok ? "OK" : "FAILED");
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,180 @@
+/* Relite
+ * Copyright (c) 2011, Google Inc.
+ * All rights reserved.
+ * Author: Dmitry Vyukov (dvyukov)
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ *     * Neither the name of Google Inc. nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+// Report ring test: a hot racy loop and a set of distinct races
+// are put into the ring; checks that the hot loop occupies a single
+// cell, that no distinct race is dropped, that the races are reported
+// again when the ring is enabled again, and that the ring is dumped
+// at exit when RELITE_REPORT_DUMP is set.
+// Usage: report_ring
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+#include "../rt/relite_rt.h"
+
+int const kSiteCount = 8;
+int const kHotIterations = 100000;
+
+static int g_hot;
+static int g_sites [kSiteCount];
+
+// every instantiation is a distinct racy code site
+template<int N>
+__attribute__((noinline)) static void race_site() {
+  g_sites[N] = N;
+  race_site<N - 1>();
+}
+
+template<>
+__attribute__((noinline)) void race_site<-1>() {
+}
+
+static void* thread_func(void*) {
+  for (int i = 0; i != kHotIterations; i += 1)
+    g_hot = i;
+  race_site<kSiteCount - 1>();
+  return 0;
+}
+
+static void run_races() {
+  pthread_t threads [2];
+  for (int i = 0; i != 2; i += 1)
+    pthread_create(&threads[i], 0, thread_func, 0);
+  for (int i = 0; i != 2; i += 1)
+    pthread_join(threads[i], 0);
+}
+
+// Checks that every site is reported and that there are no copies
+// of the hot loop report.
+static bool check_recs(char const* what,
+                       relite_report_rec_t const* recs,
+                       int count) {
+  bool ok = true;
+  int hot_count = 0;
+  for (int i = 0; i != count; i += 1)
+    hot_count += recs[i].addr == (uint64_t)&g_hot;
+  if (hot_count == 0 || hot_count > 2) {
+    printf("%s: %d reports on the hot variable\n", what, hot_count);
+    ok = false;
+  }
+  for (int s = 0; s != kSiteCount; s += 1) {
+    bool found = false;
+    for (int i = 0; i != count; i += 1)
+      found |= recs[i].addr == (uint64_t)&g_sites[s];
+    if (!found) {
+      printf("%s: no report on site %d\n", what, s);
+      ok = false;
+    }
+  }
+  return ok;
+}
+
+static bool test_drain() {
+  relite_report_ring(1);
+  run_races();
+  relite_report_ring(0);
+  static relite_report_rec_t recs [1024];
+  int const count = relite_report_drain(recs, 1024);
+  bool ok = check_recs("drain", recs, count);
+  if (relite_report_dropped() != 0) {
+    printf("drain: %llu reports dropped\n",
+           (unsigned long long)relite_report_dropped());
+    ok = false;
+  }
+  if (relite_report_drain(recs, 1024) != 0) {
+    printf("drain: the ring is not empty after drain\n");
+    ok = false;
+  }
+  return ok;
+}
+
+// Enables the ring again: the same races must be reported again.
+static bool test_drain_again() {
+  relite_report_ring(1);
+  run_races();
+  relite_report_ring(0);
+  static relite_report_rec_t recs [1024];
+  int const count = relite_report_drain(recs, 1024);
+  return check_recs("drain again", recs, count);
+}
+
+// Runs the races in a child process with RELITE_REPORT_DUMP set
+// and checks the dump it writes at exit.
+static bool test_dump(char const* self) {
+  char path [64];
+  snprintf(path, sizeof(path), "/tmp/relite_report_ring.%d", (int)getpid());
+  pid_t pid = fork();
+  if (pid == 0) {
+    setenv("RELITE_REPORT_DUMP", path, 1);
+    execl(self, self, "child", (char*)0);
+    _exit(1);
+  }
+  int status = 0;
+  waitpid(pid, &status, 0);
+  FILE* f = fopen(path, "rb");
+  if (f == 0) {
+    printf("dump: %s is not written\n", path);
+    return false;
+  }
+  static relite_report_rec_t recs [1024];
+  relite_report_dump_hdr_t hdr;
+  bool ok = fread(&hdr, sizeof(hdr), 1, f) == 1
+      && memcmp(hdr.magic, RELITE_REPORT_DUMP_MAGIC, sizeof(hdr.magic)) == 0
+      && hdr.rec_size == sizeof(relite_report_rec_t)
+      && hdr.count <= 1024
+      && fread(recs, sizeof(recs[0]), hdr.count, f) == hdr.count;
+  fclose(f);
+  unlink(path);
+  if (!ok) {
+    printf("dump: bad dump file\n");
+    return false;
+  }
+  if (hdr.dropped != 0) {
+    printf("dump: %llu reports dropped\n", (unsigned long long)hdr.dropped);
+    ok = false;
+  }
+  return check_recs("dump", recs, (int)hdr.count) && ok;
+}
+
+int main(int argc, char** argv) {
+  if (argc > 1 && strcmp(argv[1], "child") == 0) {
+    // the ring is enabled by RELITE_REPORT_DUMP and dumped at exit
+    run_races();
+    return 0;
+  }
+  bool ok = test_drain();
+  ok = test_drain_again() && ok;
+  ok = test_dump("/proc/self/exe") && ok;
+  printf("report_ring: %s\n", ok ? "OK" : "FAILED");
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,86 @@
+/* Relite
+ * Copyright (c) 2011, Google Inc.
+ * All rights reserved.
+ * Author: Dmitry Vyukov (dvyukov)
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ *     * Neither the name of Google Inc. nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+// Shadow cells test: T1 reads a variable, then T2 reads it, then T3,
+// which is ordered after T1 but not after T2, writes it. With one shadow
+// cell the read of T2 does not replace the read of T1 and the race is
+// missed; with several cells it is reported.
+// Built twice: shadow_cells with -DRELITE_SHADOW_CELLS=4 (in the test and
+// in the runtime), which must report the race, and shadow_cells_1 with
+// the default single cell, which must not.
+// Usage: shadow_cells
+
+#include <pthread.h>
+#include <stdio.h>
+#include <unistd.h>
+
+#include "../rt/relite_defs.h"
+#include "../rt/relite_rt.h"
+
+static int g_var;
+
+static void* reader_func(void*) {
+  int volatile v = g_var;
+  (void)v;
+  return 0;
+}
+
+static void* writer_func(void*) {
+  g_var = 1;
+  return 0;
+}
+
+int main() {
+  relite_report_ring(1);
+  // happens before all the accesses below
+  g_var = 0;
+  pthread_t t1, t2, t3;
+  pthread_create(&t1, 0, reader_func, 0);
+  pthread_join(t1, 0);
+  pthread_create(&t2, 0, reader_func, 0);
+  // let T2 read; T3 is not synchronized with it,
+  // since T2 is joined only after T3
+  usleep(100 * 1000);
+  pthread_create(&t3, 0, writer_func, 0);
+  pthread_join(t3, 0);
+  pthread_join(t2, 0);
+  relite_report_ring(0);
+
+  static relite_report_rec_t recs [1024];
+  int const count = relite_report_drain(recs, 1024);
+  bool found = false;
+  for (int i = 0; i != count; i += 1)
+    found |= recs[i].addr == (uint64_t)&g_var && recs[i].is_load == 0;
+  bool const expected = RELITE_SHADOW_CELLS > 1;
+  if (found != expected)
+    printf("the race of the store with the second read is %s "
+           "with %d shadow cells\n",
+           found ? "reported" : "not reported", RELITE_SHADOW_CELLS);
+  printf("shadow_cells: %s\n", found == expected ? "OK" : "FAILED");
+  return found == expected ? 0 : 1;
+}
@@ -0,0 +1,68 @@
+/* Relite
+ * Copyright (c) 2011, Google Inc.
+ * All rights reserved.
+ * Author: Dmitry Vyukov (dvyukov)
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ *     * Neither the name of Google Inc. nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+// Thread startup benchmark: spawns waves of short-lived threads,
+// so that thread descriptor allocation and reuse in the runtime dominate.
+// Usage: thread_bench [thread count] [wave width]
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <vector>
+
+static void* thread_func(void* p) {
+  // touch some memory, so that the thread is not entirely trivial;
+  // every thread has its own slot, so there is no race to report
+  int* slot = static_cast<int*>(p);
+  *slot += 1;
+  return 0;
+}
+
+static double now_ms() {
+  timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+}
+
+int main(int argc, char** argv) {
+  int const thread_count = argc > 1 ? atoi(argv[1]) : 10000;
+  int const wave_width = argc > 2 ? atoi(argv[2]) : 64;
+  std::vector<pthread_t> threads (wave_width);
+  std::vector<int> slots (wave_width);
+  double const start = now_ms();
+  for (int started = 0; started < thread_count; started += wave_width) {
+    for (int i = 0; i != wave_width; i += 1)
+      pthread_create(&threads[i], 0, thread_func, &slots[i]);
+    for (int i = 0; i != wave_width; i += 1)
+      pthread_join(threads[i], 0);
+  }
+  double const time = now_ms() - start;
+  printf("%d threads in waves of %d: %.1f ms (%.2f us/thread)\n",
+         thread_count, wave_width, time, time * 1e3 / thread_count);
+  return 0;
+}
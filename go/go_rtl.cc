@@ -33,6 +33,7 @@ void SPut(EventType type, int32_t tid, uintptr_t pc,
     CallStackPod *__tsan_shadow_stack = new CallStackPod;
     __tsan_shadow_stack->end_ = __tsan_shadow_stack->pcs_ + kCallStackReserve;
     memset(__tsan_shadow_stack->pcs_, 0, kCallStackReserve * sizeof(__tsan_shadow_stack->pcs_[0]));
+    CallStackRehash(__tsan_shadow_stack);
     pc = (uintptr_t)__tsan_shadow_stack;
   }
 
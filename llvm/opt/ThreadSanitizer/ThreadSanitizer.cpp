@@ -813,13 +813,40 @@ void ThreadSanitizer::insertRtnExit(BasicBlock::iterator &Before) {
       check.push_back(CurrentStackEnd);
       check.push_back(NewStackEnd);
       CallInst::Create(ShadowStackCheckFn, check, "", Before);
-
+      insertLowerHashedEnd(NewStackEnd, Before);
     } else {
       new StoreInst(CurrentStackEnd, StackEndPtr, Before);
+      insertLowerHashedEnd(CurrentStackEnd, Before);
     }
   }
 }
 
+// Insert the code that keeps the frame hashes of the shadow stack valid
+// after |end_| has been moved down to |StackEnd| (see CallStackPod in
+// thread_sanitizer.h). The effective C++ code for this is:
+//   if (ShadowStack.hashed_end_ > StackEnd)
+//     ShadowStack.hashed_end_ = StackEnd;
+// It is emitted as a select to keep the basic block intact.
+void ThreadSanitizer::insertLowerHashedEnd(Value *StackEnd,
+                                           BasicBlock::iterator &Before) {
+  vector <Value*> hashed_end_idx;
+  hashed_end_idx.push_back(ConstantInt::get(PlatformInt, 0));
+  hashed_end_idx.push_back(ConstantInt::get(Int32, 2));
+  Value *HashedEndPtr =
+      GetElementPtrInst::Create(ShadowStack,
+                                hashed_end_idx,
+                                "", Before);
+  Value *HashedEnd = new LoadInst(HashedEndPtr, "", Before);
+  Value *IsAbove = new ICmpInst(Before,
+                                ICmpInst::ICMP_UGT,
+                                HashedEnd,
+                                StackEnd,
+                                "");
+  Value *NewHashedEnd =
+      SelectInst::Create(IsAbove, StackEnd, HashedEnd, "", Before);
+  new StoreInst(NewHashedEnd, HashedEndPtr, Before);
+}
+
 // TODO(glider): do we need this function?
 int ThreadSanitizer::numMopsInFunction(Module::iterator &F) {
   int result = 0;
@@ -847,8 +874,11 @@ void ThreadSanitizer::runOnFunction(Module::iterator &F) {
 
   if (F->isDeclaration()) return;
   if (shouldIgnoreFunction(*F)) return;
+  bool ignore_mops = shouldIgnoreFunctionRecursively(*F);
+  // fun_sync: keep the shadow stack and calls, skip memory accesses.
+  bool sync_only = !ignore_mops && shouldInstrumentSyncOnly(*F);
 
-  if (!shouldIgnoreFunctionRecursively(*F)) {
+  if (!ignore_mops && !sync_only) {
     // We shouldn't ignore the function -- instrument it.
 
     // TODO(glider): document this.
@@ -901,7 +931,7 @@ void ThreadSanitizer::runOnFunction(Module::iterator &F) {
       runOnTrace(*(traces[i]), first_dtor_bb);
       first_dtor_bb = false;
     }
-  } else {
+  } else if (ignore_mops) {
     // Ignore the memory operations in the function.
     ignore_recursively = true;
   }
@@ -1093,16 +1123,23 @@ void ThreadSanitizer::setupDataTypes() {
   // thread_sanitizer.h:
   //
   // const size_t kMaxCallStackSize = 1 << 12;
+  // const size_t kMaxHashedCallStackSize = 1 << 8;
   // struct CallStackPod {
   //   uintptr_t *end_;
   //   uintptr_t pcs_[kMaxCallStackSize];
+  //   uintptr_t *hashed_end_;
+  //   uintptr_t hashes_[kMaxHashedCallStackSize];
   // };
   //
   // Note that |end_| points to the first invalid stack frame, i.e. the current
-  // stack frame is at *(end_ - 1).
+  // stack frame is at *(end_ - 1). The instrumentation only lowers
+  // |hashed_end_| and never touches |hashes_|.
   CallStackArrayType = ArrayType::get(PlatformInt, kMaxCallStackSize);
+  CallStackHashArrayType = ArrayType::get(PlatformInt, kMaxHashedCallStackSize);
   CallStackType = StructType::get(UIntPtr,
                                   CallStackArrayType,
+                                  UIntPtr,
+                                  CallStackHashArrayType,
                                   NULL);
 }
 
@@ -1949,9 +1986,8 @@ bool ThreadSanitizer::ignoreInlinedMop(BasicBlock::iterator &BI) {
 #endif
 #if 0
     // TODO(glider): clang integration.
-    if ((first &&
-         TripleVectorMatchKnown(Ignores.ignores, symbol, "", filename)) ||
-        TripleVectorMatchKnown(Ignores.ignores_r, symbol, "", filename)) {
+    if ((first && Ignores.ignores.Match(symbol, "", filename)) ||
+        Ignores.ignores_r.Match(symbol, "", filename)) {
 #else
     if (0) {
 #endif
@@ -2467,7 +2503,10 @@ void ThreadSanitizer::parseIgnoreFile(string &file) {
 #if 0
   // TODO(glider): integrate ignores with Clang.
   string ignore_contents = ReadFileToString(file, /*die_if_failed*/true);
-  ReadIgnoresFromString(ignore_contents, &Ignores);
+  IgnoreLists lists;
+  ReadIgnoresFromString(ignore_contents, &lists);
+  // Compile the lists once instead of matching each pattern per function.
+  Ignores.Init(lists);
 #endif
 }
 
@@ -2477,7 +2516,7 @@ bool ThreadSanitizer::shouldIgnoreFunction(Function &F) {
   DILocation Loc(F.begin()->begin()->getMetadata("dbg"));
   string filename = Loc.getFilename();
   string symbol = F.getNameStr();
-  return TripleVectorMatchKnown(Ignores.ignores, symbol, "", filename);
+  return Ignores.ignores.Match(symbol, "", filename);
 #else
   return false;
 #endif
@@ -2489,7 +2528,19 @@ bool ThreadSanitizer::shouldIgnoreFunctionRecursively(Function &F) {
   DILocation Loc(F.begin()->begin()->getMetadata("dbg"));
   string filename = Loc.getFilename();
   string symbol = F.getNameStr();
-  return TripleVectorMatchKnown(Ignores.ignores_r, symbol, "", filename);
+  return Ignores.ignores_r.Match(symbol, "", filename);
+#else
+  return false;
+#endif
+}
+
+bool ThreadSanitizer::shouldInstrumentSyncOnly(Function &F) {
+#if 0
+  // TODO(glider): clang integration.
+  DILocation Loc(F.begin()->begin()->getMetadata("dbg"));
+  string filename = Loc.getFilename();
+  string symbol = F.getNameStr();
+  return Ignores.ignores_sync.Match(symbol, "", filename);
 #else
   return false;
 #endif
@@ -134,10 +134,13 @@ struct ThreadSanitizer : public llvm::ModulePass { // {{{1
   bool makeTracePassport(Trace &trace);
   bool shouldIgnoreFunction(llvm::Function &F);
   bool shouldIgnoreFunctionRecursively(llvm::Function &F);
+  bool shouldInstrumentSyncOnly(llvm::Function &F);
   // Instrumentation routines.
   void insertRtnCall(llvm::Constant *addr,
                      llvm::BasicBlock::iterator &Before);
   void insertRtnExit(llvm::BasicBlock::iterator &Before);
+  void insertLowerHashedEnd(llvm::Value *StackEnd,
+                            llvm::BasicBlock::iterator &Before);
   void writeRtnCallToTleb(llvm::Constant *Addr,
                           llvm::BasicBlock::iterator &Before);
   void writeRtnExitToTleb(llvm::BasicBlock::iterator &Before);
@@ -162,7 +165,7 @@ struct ThreadSanitizer : public llvm::ModulePass { // {{{1
   static char ID; // Pass identification, replacement for typeid
 #if 0
   // TODO(glider): clang integration.
-  IgnoreLists Ignores;
+  IgnoreMatchers Ignores;
 #endif
   int ArchSize;
   int ModuleID;
@@ -194,7 +197,7 @@ struct ThreadSanitizer : public llvm::ModulePass { // {{{1
   llvm::Type *TLEBTy;
   llvm::PointerType *TLEBPtrTy;
   llvm::StructType *CallStackType;
-  const llvm::ArrayType *CallStackArrayType;
+  const llvm::ArrayType *CallStackArrayType, *CallStackHashArrayType;
 
   // Globals provided by the RTL.
   llvm::Value *ShadowStack, *CurrentStackEnd;
@@ -219,6 +222,7 @@ struct ThreadSanitizer : public llvm::ModulePass { // {{{1
   static const int kLiteRaceNumTids = 8;
   static const int kLiteRaceStorageSize = 8;
   static const size_t kMaxCallStackSize = 1 << 12;
+  static const size_t kMaxHashedCallStackSize = 1 << 8;
   static const uintptr_t kRtnMask32 = 1L<<31;
   static const uintptr_t kRtnMask64 = 1L<<63;
   static const uintptr_t kSblockMask32 = 1L<<30;
@@ -34,6 +34,9 @@
 // DenseMultimap is imilar to STL multimap, but optimized for memory.
 // DenseMultimap objects are immutable after creation.
 // All CTORs have linear complexity.
+// Up to kPreallocatedElements elements are stored inline, without a heap
+// allocation; such small maps are searched with branch-free linear scans
+// which the compiler can vectorize.
 template<class T, int kPreallocatedElements>
 class DenseMultimap {
  public:
@@ -101,7 +104,35 @@ class DenseMultimap {
   const_iterator end()   const { return ptr_ + size(); }
 
   bool has(const T&t) const {
-    return binary_search(begin(), end(), t);
+    if (size_ > kPreallocatedElements)
+      return binary_search(begin(), end(), t);
+    bool res = false;
+    for (int i = 0; i < size_; i++)
+      res |= (ptr_[i] == t);
+    return res;
+  }
+
+  // Return true if this and m have at least one common element.
+  bool Intersects(const DenseMultimap &m) const {
+    if (size_ <= kPreallocatedElements && m.size_ <= kPreallocatedElements) {
+      bool res = false;
+      for (int i = 0; i < size_; i++)
+        for (int j = 0; j < m.size_; j++)
+          res |= (ptr_[i] == m.ptr_[j]);
+      return res;
+    }
+    // Merge the two sorted arrays.
+    const_iterator it1 = begin(), it2 = m.begin();
+    while (it1 != end() && it2 != m.end()) {
+      if (*it1 < *it2) {
+        ++it1;
+      } else if (*it2 < *it1) {
+        ++it2;
+      } else {
+        return true;
+      }
+    }
+    return false;
   }
 
   bool operator < (const DenseMultimap &m) const {
@@ -54,6 +54,8 @@ static bool ReadIgnoreLine(string input_line, IgnoreLists *ignore_lists) {
     ignore_lists->ignores_r.push_back(IgnoreFun(tail));
   } else if (CutStringPrefixIfPresent(input_line, "fun_hist:", &tail)) {
     ignore_lists->ignores_hist.push_back(IgnoreFun(tail));
+  } else if (CutStringPrefixIfPresent(input_line, "fun_sync:", &tail)) {
+    ignore_lists->ignores_sync.push_back(IgnoreFun(tail));
   } else {
     return false;
   }
@@ -99,6 +101,70 @@ bool TripleVectorMatchKnown(const vector<IgnoreTriple>& v,
   return false;
 }
 
+void IgnoreMatcher::Init(const vector<IgnoreTriple>& v) {
+  trie_.clear();
+  trie_.push_back(Node());
+  other_.clear();
+  num_patterns_ = v.size();
+  for (size_t i = 0; i < v.size(); i++) {
+    if (v[i].obj != "*" || v[i].file != "*") {
+      other_.push_back(v[i]);
+      continue;
+    }
+    const string &fun = v[i].fun;
+    size_t prefix_len = fun.find_first_of("*?");
+    if (prefix_len == string::npos)
+      prefix_len = fun.size();
+    size_t node = 0;
+    for (size_t j = 0; j < prefix_len; j++) {
+      map<char, size_t>::iterator it = trie_[node].children.find(fun[j]);
+      if (it == trie_[node].children.end()) {
+        trie_.push_back(Node());
+        it = trie_[node].children.insert(
+            make_pair(fun[j], trie_.size() - 1)).first;
+      }
+      node = it->second;
+    }
+    trie_[node].tails.push_back(fun.substr(prefix_len));
+  }
+}
+
+// True iff |tail| (which is empty or starts with a wildcard)
+// matches the whole |text|.
+static bool MatchTail(const string &tail, const char *text) {
+  if (tail.empty())
+    return *text == 0;
+  if (*text == 0)
+    return tail.find_first_not_of('*') == string::npos;
+  return ThreadSanitizerStringMatch(tail, text);
+}
+
+bool IgnoreMatcher::MatchFun(const string& fun) const {
+  size_t node = 0;
+  for (size_t pos = 0;; pos++) {
+    const Node &n = trie_[node];
+    for (size_t i = 0; i < n.tails.size(); i++) {
+      if (MatchTail(n.tails[i], fun.c_str() + pos))
+        return true;
+    }
+    if (pos == fun.size())
+      return false;
+    map<char, size_t>::const_iterator it = n.children.find(fun[pos]);
+    if (it == n.children.end())
+      return false;
+    node = it->second;
+  }
+}
+
+bool IgnoreMatcher::Match(const string& fun, const string& obj,
+                          const string& file) const {
+  // A function-only pattern never matches an empty function name,
+  // see TripleVectorMatchKnown().
+  if (!fun.empty() && MatchFun(fun))
+    return true;
+  return !other_.empty() && TripleVectorMatchKnown(other_, fun, obj, file);
+}
+
 bool StringVectorMatch(const vector<string>& v, const string& obj) {
   for (size_t i = 0; i < v.size(); i++)
     if (ThreadSanitizerStringMatch(v[i], obj))
@@ -33,6 +33,58 @@ struct IgnoreLists {
   vector<IgnoreTriple> ignores;
   vector<IgnoreTriple> ignores_r;
   vector<IgnoreTriple> ignores_hist;
+  vector<IgnoreTriple> ignores_sync;  // fun_sync: instrument sync only.
+};
+
+// A precompiled form of a vector of ignore triples.
+// Match() gives the same answer as TripleVectorMatchKnown(), but
+// function-only patterns (the common case) are put into a trie by their
+// literal prefix, so only the patterns sharing a prefix with the name
+// are matched as globs.
+class IgnoreMatcher {
+ public:
+  IgnoreMatcher() { Init(vector<IgnoreTriple>()); }
+  explicit IgnoreMatcher(const vector<IgnoreTriple>& v) { Init(v); }
+
+  void Init(const vector<IgnoreTriple>& v);
+
+  bool Match(const string& fun, const string& obj, const string& file) const;
+
+  // Matches a function by its mangled and demangled names.
+  bool MatchFunction(const string& mangled, const string& demangled,
+                     const string& file) const {
+    return Match(mangled, "", file) ||
+           (!demangled.empty() && Match(demangled, "", file));
+  }
+
+  bool empty() const { return num_patterns_ == 0; }
+
+ private:
+  struct Node {
+    map<char, size_t> children;
+    vector<string> tails;  // Pattern tails after this prefix ("" for exact).
+  };
+
+  bool MatchFun(const string& fun) const;
+
+  vector<Node> trie_;
+  vector<IgnoreTriple> other_;  // Triples with obj or file patterns.
+  size_t num_patterns_;
+};
+
+// All the ignore lists in precompiled form.
+struct IgnoreMatchers {
+  IgnoreMatcher ignores;
+  IgnoreMatcher ignores_r;
+  IgnoreMatcher ignores_hist;
+  IgnoreMatcher ignores_sync;
+
+  void Init(const IgnoreLists& lists) {
+    ignores.Init(lists.ignores);
+    ignores_r.Init(lists.ignores_r);
+    ignores_hist.Init(lists.ignores_hist);
+    ignores_sync.Init(lists.ignores_sync);
+  }
 };
 
 extern IgnoreLists *g_ignore_lists;
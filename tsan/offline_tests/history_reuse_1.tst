@@ -0,0 +1,1008 @@
+THR_START 0 0 0 0
+THR_CREATE_BEFORE 0 0 0 0
+THR_START 1 0 0 0
+THR_CREATE_AFTER 0 0 0 1
+RTN_CALL 0 c0000001 c0000002 0
+SBLOCK_ENTER 0 1000 0 0
+WRITE 0 1001 100000 4
+RTN_CALL 0 2000 d0000000 0
+RTN_CALL 0 d0000010 e0000000 0
+RTN_CALL 0 e0000010 f0000000 0
+SBLOCK_ENTER 0 f0000020 0 0
+WRITE 0 f0000021 100008 4
+RTN_EXIT 0 0 0 0
+RTN_EXIT 0 0 0 0
+RTN_EXIT 0 0 0 0
+SBLOCK_ENTER 0 1010 0 0
+WRITE 0 1011 100010 4
+RTN_CALL 0 2001 d0000000 0
+RTN_CALL 0 d0000010 e0000000 0
+RTN_CALL 0 e0000010 f0000000 0
+SBLOCK_ENTER 0 f0000020 0 0
+WRITE 0 f0000021 100018 4
+RTN_EXIT 0 0 0 0
+RTN_EXIT 0 0 0 0
+RTN_EXIT 0 0 0 0
+SBLOCK_ENTER 0 1000 0 0
+WRITE 0 1001 100020 4
+RTN_CALL 0 2002 d0000000 0
+RTN_CALL 0 d0000010 e0000000 0
+RTN_CALL 0 e0000010 f0000000 0
+SBLOCK_ENTER 0 f0000020 0 0
+WRITE 0 f0000021 100028 4
+RTN_EXIT 0 0 0 0
+RTN_EXIT 0 0 0 0
+RTN_EXIT 0 0 0 0
+SBLOCK_ENTER 0 1010 0 0
+WRITE 0 1011 100030 4
+RTN_CALL 0 2003 d0000000 0
+RTN_CALL 0 d0000010 e0000000 0
+RTN_CALL 0 e0000010 f0000000 0
+SBLOCK_ENTER 0 f0000020 0 0
+WRITE 0 f0000021 100038 4
+RTN_EXIT 0 0 0 0
+RTN_EXIT 0 0 0 0
+RTN_EXIT 0 0 0 0
+SBLOCK_ENTER 0 1000 0 0
+WRITE 0 1001 100040 4
+RTN_CALL 0 2004 d0000000 0
+RTN_CALL 0 d0000010 e0000000 0
+RTN_CALL 0 e0000010 f0000000 0
+SBLOCK_ENTER 0 f0000020 0 0
+WRITE 0 f0000021 100048 4
+RTN_EXIT 0 0 0 0
+RTN_EXIT 0 0 0 0
+RTN_EXIT 0 0 0 0
+SBLOCK_ENTER 0 1010 0 0
+WRITE 0 1011 100050 4
+RTN_CALL 0 2005 d0000000 0
+RTN_CALL 0 d0000010 e0000000 0
+RTN_CALL 0 e0000010 f0000000 0
+SBLOCK_ENTER 0 f0000020 0 0
+WRITE 0 f0000021 100058 4
+RTN_EXIT 0 0 0 0
+RTN_EXIT 0 0 0 0
+RTN_EXIT 0 0 0 0
+SBLOCK_ENTER 0 1000 0 0
+WRITE 0 1001 100060 4
+RTN_CALL 0 2006 d0000000 0
+RTN_CALL 0 d0000010 e0000000 0
+RTN_CALL 0 e0000010 f0000000 0
+SBLOCK_ENTER 0 f0000020 0 0
+WRITE 0 f0000021 100068 4
+RTN_EXIT 0 0 0 0
+RTN_EXIT 0 0 0 0
+RTN_EXIT 0 0 0 0
+SBLOCK_ENTER 0 1010 0 0
+WRITE 0 1011 100070 4
+RTN_CALL 0 2007 d0000000 0
+RTN_CALL 0 d0000010 e0000000 0
+RTN_CALL 0 e0000010 f0000000 0
+SBLOCK_ENTER 0 f0000020 0 0
+WRITE 0 f0000021 100078 4
+RTN_EXIT 0 0 0 0
+RTN_EXIT 0 0 0 0
+RTN_EXIT 0 0 0 0
+SBLOCK_ENTER 0 1000 0 0
+WRITE 0 1001 100080 4
+RTN_CALL 0 2008 d0000000 0
+RTN_CALL 0 d0000010 e0000000 0
+RTN_CALL 0 e0000010 f0000000 0
+SBLOCK_ENTER 0 f0000020 0 0
+WRITE 0 f0000021 100088 4
+RTN_EXIT 0 0 0 0
+RTN_EXIT 0 0 0 0
+RTN_EXIT 0 0 0 0
+SBLOCK_ENTER 0 1010 0 0
+WRITE 0 1011 100090 4
+RTN_CALL 0 2009 d0000000 0
+RTN_CALL 0 d0000010 e0000000 0
+RTN_CALL 0 e0000010 f0000000 0
+SBLOCK_ENTER 0 f0000020 0 0
+WRITE 0 f0000021 100098 4
+RTN_EXIT 0 0 0 0
+RTN_EXIT 0 0 0 0
+RTN_EXIT 0 0 0 0
+SBLOCK_ENTER 0 1000 0 0
+WRITE 0 1001 1000a0 4
+RTN_CALL 0 200a d0000000 0
+RTN_CALL 0 d0000010 e0000000 0
+RTN_CALL 0 e0000010 f0000000 0
+SBLOCK_ENTER 0 f0000020 0 0
+WRITE 0 f0000021 1000a8 4
+RTN_EXIT 0 0 0 0
+RTN_EXIT 0 0 0 0
+RTN_EXIT 0 0 0 0
+SBLOCK_ENTER 0 1010 0 0
+WRITE 0 1011 1000b0 4
+RTN_CALL 0 200b d0000000 0
+RTN_CALL 0 d0000010 e0000000 0
+RTN_CALL 0 e0000010 f0000000 0
+SBLOCK_ENTER 0 f0000020 0 0
+WRITE 0 f0000021 1000b8 4
+RTN_EXIT 0 0 0 0
+RTN_EXIT 0 0 0 0
+RTN_EXIT 0 0 0 0
+SBLOCK_ENTER 0 1000 0 0
+WRITE 0 1001 1000c0 4
+RTN_CALL 0 200c d0000000 0
+RTN_CALL 0 d0000010 e0000000 0
+RTN_CALL 0 e0000010 f0000000 0
+SBLOCK_ENTER 0 f0000020 0 0
+WRITE 0 f0000021 1000c8 4
+RTN_EXIT 0 0 0 0
+RTN_EXIT 0 0 0 0
+RTN_EXIT 0 0 0 0
+SBLOCK_ENTER 0 1010 0 0
+WRITE 0 1011 1000d0 4
+RTN_CALL 0 200d d0000000 0
+RTN_CALL 0 d0000010 e0000000 0
+RTN_CALL 0 e0000010 f0000000 0
+SBLOCK_ENTER 0 f0000020 0 0
+WRITE 0 f0000021 1000d8 4
+RTN_EXIT 0 0 0 0
+RTN_EXIT 0 0 0 0
+RTN_EXIT 0 0 0 0
+SBLOCK_ENTER 0 1000 0 0
+WRITE 0 1001 1000e0 4
+RTN_CALL 0 200e d0000000 0
+RTN_CALL 0 d0000010 e0000000 0
+RTN_CALL 0 e0000010 f0000000 0
+SBLOCK_ENTER 0 f0000020 0 0
+WRITE 0 f0000021 1000e8 4
+RTN_EXIT 0 0 0 0
+RTN_EXIT 0 0 0 0
+RTN_EXIT 0 0 0 0
+SBLOCK_ENTER 0 1010 0 0
+WRITE 0 1011 1000f0 4
+RTN_CALL 0 200f d0000000 0
+RTN_CALL 0 d0000010 e0000000 0
+RTN_CALL 0 e0000010 f0000000 0
+SBLOCK_ENTER 0 f0000020 0 0
+WRITE 0 f0000021 1000f8 4
+RTN_EXIT 0 0 0 0
+RTN_EXIT 0 0 0 0
+RTN_EXIT 0 0 0 0
+SBLOCK_ENTER 0 1000 0 0
+WRITE 0 1001 100100 4
+RTN_CALL 0 2010 d0000000 0
+RTN_CALL 0 d0000010 e0000000 0
+RTN_CALL 0 e0000010 f0000000 0
+SBLOCK_ENTER 0 f0000020 0 0
+WRITE 0 f0000021 100108 4
+RTN_EXIT 0 0 0 0
+RTN_EXIT 0 0 0 0
+RTN_EXIT 0 0 0 0
+SBLOCK_ENTER 0 1010 0 0
+WRITE 0 1011 100110 4
+RTN_CALL 0 2011 d0000000 0
+RTN_CALL 0 d0000010 e0000000 0
+RTN_CALL 0 e0000010 f0000000 0
+SBLOCK_ENTER 0 f0000020 0 0
+WRITE 0 f0000021 100118 4
+RTN_EXIT 0 0 0 0
+RTN_EXIT 0 0 0 0
+RTN_EXIT 0 0 0 0
+SBLOCK_ENTER 0 1000 0 0
+WRITE 0 1001 100120 4
+RTN_CALL 0 2012 d0000000 0
+RTN_CALL 0 d0000010 e0000000 0
+RTN_CALL 0 e0000010 f0000000 0
+SBLOCK_ENTER 0 f0000020 0 0
+WRITE 0 f0000021 100128 4
+RTN_EXIT 0 0 0 0
+RTN_EXIT 0 0 0 0
+RTN_EXIT 0 0 0 0
+SBLOCK_ENTER 0 1010 0 0
+WRITE 0 1011 100130 4
+RTN_CALL 0 2013 d0000000 0
+RTN_CALL 0 d0000010 e0000000 0
+RTN_CALL 0 e0000010 f0000000 0
+SBLOCK_ENTER 0 f0000020 0 0
+WRITE 0 f0000021 100138 4
+RTN_EXIT 0 0 0 0
+RTN_EXIT 0 0 0 0
+RTN_EXIT 0 0 0 0
+SBLOCK_ENTER 0 1000 0 0
+WRITE 0 1001 100140 4
+RTN_CALL 0 2014 d0000000 0
+RTN_CALL 0 d0000010 e0000000 0
+RTN_CALL 0 e0000010 f0000000 0
+SBLOCK_ENTER 0 f0000020 0 0
+WRITE 0 f0000021 100148 4
+RTN_EXIT 0 0 0 0
+RTN_EXIT 0 0 0 0
+RTN_EXIT 0 0 0 0
+SBLOCK_ENTER 0 1010 0 0
+WRITE 0 1011 100150 4
+RTN_CALL 0 2015 d0000000 0
+RTN_CALL 0 d0000010 e0000000 0
+RTN_CALL 0 e0000010 f0000000 0
+SBLOCK_ENTER 0 f0000020 0 0
+WRITE 0 f0000021 100158 4
+RTN_EXIT 0 0 0 0
+RTN_EXIT 0 0 0 0
+RTN_EXIT 0 0 0 0
+SBLOCK_ENTER 0 1000 0 0
+WRITE 0 1001 100160 4
+RTN_CALL 0 2016 d0000000 0
+RTN_CALL 0 d0000010 e0000000 0
+RTN_CALL 0 e0000010 f0000000 0
+SBLOCK_ENTER 0 f0000020 0 0
+WRITE 0 f0000021 100168 4
+RTN_EXIT 0 0 0 0
+RTN_EXIT 0 0 0 0
+RTN_EXIT 0 0 0 0
+SBLOCK_ENTER 0 1010 0 0
+WRITE 0 1011 100170 4
+RTN_CALL 0 2017 d0000000 0
+RTN_CALL 0 d0000010 e0000000 0
+RTN_CALL 0 e0000010 f0000000 0
+SBLOCK_ENTER 0 f0000020 0 0
+WRITE 0 f0000021 100178 4
+RTN_EXIT 0 0 0 0
+RTN_EXIT 0 0 0 0
+RTN_EXIT 0 0 0 0
+SBLOCK_ENTER 0 1000 0 0
+WRITE 0 1001 100180 4
+RTN_CALL 0 2018 d0000000 0
+RTN_CALL 0 d0000010 e0000000 0
+RTN_CALL 0 e0000010 f0000000 0
+SBLOCK_ENTER 0 f0000020 0 0
+WRITE 0 f0000021 100188 4
+RTN_EXIT 0 0 0 0
+RTN_EXIT 0 0 0 0
+RTN_EXIT 0 0 0 0
+SBLOCK_ENTER 0 1010 0 0
+WRITE 0 1011 100190 4
+RTN_CALL 0 2019 d0000000 0
+RTN_CALL 0 d0000010 e0000000 0
+RTN_CALL 0 e0000010 f0000000 0
+SBLOCK_ENTER 0 f0000020 0 0
+WRITE 0 f0000021 100198 4
+RTN_EXIT 0 0 0 0
+RTN_EXIT 0 0 0 0
+RTN_EXIT 0 0 0 0
+SBLOCK_ENTER 0 1000 0 0
+WRITE 0 1001 1001a0 4
+RTN_CALL 0 201a d0000000 0
+RTN_CALL 0 d0000010 e0000000 0
+RTN_CALL 0 e0000010 f0000000 0
+SBLOCK_ENTER 0 f0000020 0 0
+WRITE 0 f0000021 1001a8 4
+RTN_EXIT 0 0 0 0
+RTN_EXIT 0 0 0 0
+RTN_EXIT 0 0 0 0
+SBLOCK_ENTER 0 1010 0 0
+WRITE 0 1011 1001b0 4
+RTN_CALL 0 201b d0000000 0
+RTN_CALL 0 d0000010 e0000000 0
+RTN_CALL 0 e0000010 f0000000 0
+SBLOCK_ENTER 0 f0000020 0 0
+WRITE 0 f0000021 1001b8 4
+RTN_EXIT 0 0 0 0
+RTN_EXIT 0 0 0 0
+RTN_EXIT 0 0 0 0
+SBLOCK_ENTER 0 1000 0 0
+WRITE 0 1001 1001c0 4
+RTN_CALL 0 201c d0000000 0
+RTN_CALL 0 d0000010 e0000000 0
+RTN_CALL 0 e0000010 f0000000 0
+SBLOCK_ENTER 0 f0000020 0 0
+WRITE 0 f0000021 1001c8 4
+RTN_EXIT 0 0 0 0
+RTN_EXIT 0 0 0 0
+RTN_EXIT 0 0 0 0
+SBLOCK_ENTER 0 1010 0 0
+WRITE 0 1011 1001d0 4
+RTN_CALL 0 201d d0000000 0
+RTN_CALL 0 d0000010 e0000000 0
+RTN_CALL 0 e0000010 f0000000 0
+SBLOCK_ENTER 0 f0000020 0 0
+WRITE 0 f0000021 1001d8 4
+RTN_EXIT 0 0 0 0
+RTN_EXIT 0 0 0 0
+RTN_EXIT 0 0 0 0
+SBLOCK_ENTER 0 1000 0 0
+WRITE 0 1001 1001e0 4
+RTN_CALL 0 201e d0000000 0
+RTN_CALL 0 d0000010 e0000000 0
+RTN_CALL 0 e0000010 f0000000 0
+SBLOCK_ENTER 0 f0000020 0 0
+WRITE 0 f0000021 1001e8 4
+RTN_EXIT 0 0 0 0
+RTN_EXIT 0 0 0 0
+RTN_EXIT 0 0 0 0
+SBLOCK_ENTER 0 1010 0 0
+WRITE 0 1011 1001f0 4
+RTN_CALL 0 201f d0000000 0
+RTN_CALL 0 d0000010 e0000000 0
+RTN_CALL 0 e0000010 f0000000 0
+SBLOCK_ENTER 0 f0000020 0 0
+WRITE 0 f0000021 1001f8 4
+RTN_EXIT 0 0 0 0
+RTN_EXIT 0 0 0 0
+RTN_EXIT 0 0 0 0
+SBLOCK_ENTER 0 1000 0 0
+WRITE 0 1001 100200 4
+RTN_CALL 0 2020 d0000000 0
+RTN_CALL 0 d0000010 e0000000 0
+RTN_CALL 0 e0000010 f0000000 0
+SBLOCK_ENTER 0 f0000020 0 0
+WRITE 0 f0000021 100208 4
+RTN_EXIT 0 0 0 0
+RTN_EXIT 0 0 0 0
+RTN_EXIT 0 0 0 0
+SBLOCK_ENTER 0 1010 0 0
+WRITE 0 1011 100210 4
+RTN_CALL 0 2021 d0000000 0
+RTN_CALL 0 d0000010 e0000000 0
+RTN_CALL 0 e0000010 f0000000 0
+SBLOCK_ENTER 0 f0000020 0 0
+WRITE 0 f0000021 100218 4
+RTN_EXIT 0 0 0 0
+RTN_EXIT 0 0 0 0
+RTN_EXIT 0 0 0 0
+SBLOCK_ENTER 0 1000 0 0
+WRITE 0 1001 100220 4
+RTN_CALL 0 2022 d0000000 0
+RTN_CALL 0 d0000010 e0000000 0
+RTN_CALL 0 e0000010 f0000000 0
+SBLOCK_ENTER 0 f0000020 0 0
+WRITE 0 f0000021 100228 4
+RTN_EXIT 0 0 0 0
+RTN_EXIT 0 0 0 0
+RTN_EXIT 0 0 0 0
+SBLOCK_ENTER 0 1010 0 0
+WRITE 0 1011 100230 4
+RTN_CALL 0 2023 d0000000 0
+RTN_CALL 0 d0000010 e0000000 0
+RTN_CALL 0 e0000010 f0000000 0
+SBLOCK_ENTER 0 f0000020 0 0
+WRITE 0 f0000021 100238 4
+RTN_EXIT 0 0 0 0
+RTN_EXIT 0 0 0 0
+RTN_EXIT 0 0 0 0
+SBLOCK_ENTER 0 1000 0 0
+WRITE 0 1001 100240 4
+RTN_CALL 0 2024 d0000000 0
+RTN_CALL 0 d0000010 e0000000 0
+RTN_CALL 0 e0000010 f0000000 0
+SBLOCK_ENTER 0 f0000020 0 0
+WRITE 0 f0000021 100248 4
+RTN_EXIT 0 0 0 0
+RTN_EXIT 0 0 0 0
+RTN_EXIT 0 0 0 0
+SBLOCK_ENTER 0 1010 0 0
+WRITE 0 1011 100250 4
+RTN_CALL 0 2025 d0000000 0
+RTN_CALL 0 d0000010 e0000000 0
+RTN_CALL 0 e0000010 f0000000 0
+SBLOCK_ENTER 0 f0000020 0 0
+WRITE 0 f0000021 100258 4
+RTN_EXIT 0 0 0 0
+RTN_EXIT 0 0 0 0
+RTN_EXIT 0 0 0 0
+SBLOCK_ENTER 0 1000 0 0
+WRITE 0 1001 100260 4
+RTN_CALL 0 2026 d0000000 0
+RTN_CALL 0 d0000010 e0000000 0
+RTN_CALL 0 e0000010 f0000000 0
+SBLOCK_ENTER 0 f0000020 0 0
+WRITE 0 f0000021 100268 4
+RTN_EXIT 0 0 0 0
+RTN_EXIT 0 0 0 0
+RTN_EXIT 0 0 0 0
+SBLOCK_ENTER 0 1010 0 0
+WRITE 0 1011 100270 4
+RTN_CALL 0 2027 d0000000 0
+RTN_CALL 0 d0000010 e0000000 0
+RTN_CALL 0 e0000010 f0000000 0
+SBLOCK_ENTER 0 f0000020 0 0
+WRITE 0 f0000021 100278 4
+RTN_EXIT 0 0 0 0
+RTN_EXIT 0 0 0 0
+RTN_EXIT 0 0 0 0
+SBLOCK_ENTER 0 1000 0 0
+WRITE 0 1001 100280 4
+RTN_CALL 0 2028 d0000000 0
+RTN_CALL 0 d0000010 e0000000 0
+RTN_CALL 0 e0000010 f0000000 0
+SBLOCK_ENTER 0 f0000020 0 0
+WRITE 0 f0000021 100288 4
+RTN_EXIT 0 0 0 0
+RTN_EXIT 0 0 0 0
+RTN_EXIT 0 0 0 0
+SBLOCK_ENTER 0 1010 0 0
+WRITE 0 1011 100290 4
+RTN_CALL 0 2029 d0000000 0
+RTN_CALL 0 d0000010 e0000000 0
+RTN_CALL 0 e0000010 f0000000 0
+SBLOCK_ENTER 0 f0000020 0 0
+WRITE 0 f0000021 100298 4
+RTN_EXIT 0 0 0 0
+RTN_EXIT 0 0 0 0
+RTN_EXIT 0 0 0 0
+SBLOCK_ENTER 0 1000 0 0
+WRITE 0 1001 1002a0 4
+RTN_CALL 0 202a d0000000 0
+RTN_CALL 0 d0000010 e0000000 0
+RTN_CALL 0 e0000010 f0000000 0
+SBLOCK_ENTER 0 f0000020 0 0
+WRITE 0 f0000021 1002a8 4
+RTN_EXIT 0 0 0 0
+RTN_EXIT 0 0 0 0
+RTN_EXIT 0 0 0 0
+SBLOCK_ENTER 0 1010 0 0
+WRITE 0 1011 1002b0 4
+RTN_CALL 0 202b d0000000 0
+RTN_CALL 0 d0000010 e0000000 0
+RTN_CALL 0 e0000010 f0000000 0
+SBLOCK_ENTER 0 f0000020 0 0
+WRITE 0 f0000021 1002b8 4
+RTN_EXIT 0 0 0 0
+RTN_EXIT 0 0 0 0
+RTN_EXIT 0 0 0 0
+SBLOCK_ENTER 0 1000 0 0
+WRITE 0 1001 1002c0 4
+RTN_CALL 0 202c d0000000 0
+RTN_CALL 0 d0000010 e0000000 0
+RTN_CALL 0 e0000010 f0000000 0
+SBLOCK_ENTER 0 f0000020 0 0
+WRITE 0 f0000021 1002c8 4
+RTN_EXIT 0 0 0 0
+RTN_EXIT 0 0 0 0
+RTN_EXIT 0 0 0 0
+SBLOCK_ENTER 0 1010 0 0
+WRITE 0 1011 1002d0 4
+RTN_CALL 0 202d d0000000 0
+RTN_CALL 0 d0000010 e0000000 0
+RTN_CALL 0 e0000010 f0000000 0
+SBLOCK_ENTER 0 f0000020 0 0
+WRITE 0 f0000021 1002d8 4
+RTN_EXIT 0 0 0 0
+RTN_EXIT 0 0 0 0
+RTN_EXIT 0 0 0 0
+SBLOCK_ENTER 0 1000 0 0
+WRITE 0 1001 1002e0 4
+RTN_CALL 0 202e d0000000 0
+RTN_CALL 0 d0000010 e0000000 0
+RTN_CALL 0 e0000010 f0000000 0
+SBLOCK_ENTER 0 f0000020 0 0
+WRITE 0 f0000021 1002e8 4
+RTN_EXIT 0 0 0 0
+RTN_EXIT 0 0 0 0
+RTN_EXIT 0 0 0 0
+SBLOCK_ENTER 0 1010 0 0
+WRITE 0 1011 1002f0 4
+RTN_CALL 0 202f d0000000 0
+RTN_CALL 0 d0000010 e0000000 0
+RTN_CALL 0 e0000010 f0000000 0
+SBLOCK_ENTER 0 f0000020 0 0
+WRITE 0 f0000021 1002f8 4
+RTN_EXIT 0 0 0 0
+RTN_EXIT 0 0 0 0
+RTN_EXIT 0 0 0 0
+SBLOCK_ENTER 0 1000 0 0
+WRITE 0 1001 100300 4
+RTN_CALL 0 2030 d0000000 0
+RTN_CALL 0 d0000010 e0000000 0
+RTN_CALL 0 e0000010 f0000000 0
+SBLOCK_ENTER 0 f0000020 0 0
+WRITE 0 f0000021 100308 4
+RTN_EXIT 0 0 0 0
+RTN_EXIT 0 0 0 0
+RTN_EXIT 0 0 0 0
+SBLOCK_ENTER 0 1010 0 0
+WRITE 0 1011 100310 4
+RTN_CALL 0 2031 d0000000 0
+RTN_CALL 0 d0000010 e0000000 0
+RTN_CALL 0 e0000010 f0000000 0
+SBLOCK_ENTER 0 f0000020 0 0
+WRITE 0 f0000021 100318 4
+RTN_EXIT 0 0 0 0
+RTN_EXIT 0 0 0 0
+RTN_EXIT 0 0 0 0
+SBLOCK_ENTER 0 1000 0 0
+WRITE 0 1001 100320 4
+RTN_CALL 0 2000 d0000000 0
+RTN_CALL 0 d0000010 e0000000 0
+RTN_CALL 0 e0000010 f0000000 0
+SBLOCK_ENTER 0 f0000020 0 0
+WRITE 0 f0000021 100328 4
+RTN_EXIT 0 0 0 0
+RTN_EXIT 0 0 0 0
+RTN_EXIT 0 0 0 0
+SBLOCK_ENTER 0 1010 0 0
+WRITE 0 1011 100330 4
+RTN_CALL 0 2001 d0000000 0
+RTN_CALL 0 d0000010 e0000000 0
+RTN_CALL 0 e0000010 f0000000 0
+SBLOCK_ENTER 0 f0000020 0 0
+WRITE 0 f0000021 100338 4
+RTN_EXIT 0 0 0 0
+RTN_EXIT 0 0 0 0
+RTN_EXIT 0 0 0 0
+SBLOCK_ENTER 0 1000 0 0
+WRITE 0 1001 100340 4
+RTN_CALL 0 2002 d0000000 0
+RTN_CALL 0 d0000010 e0000000 0
+RTN_CALL 0 e0000010 f0000000 0
+SBLOCK_ENTER 0 f0000020 0 0
+WRITE 0 f0000021 100348 4
+RTN_EXIT 0 0 0 0
+RTN_EXIT 0 0 0 0
+RTN_EXIT 0 0 0 0
+SBLOCK_ENTER 0 1010 0 0
+WRITE 0 1011 100350 4
+RTN_CALL 0 2003 d0000000 0
+RTN_CALL 0 d0000010 e0000000 0
+RTN_CALL 0 e0000010 f0000000 0
+SBLOCK_ENTER 0 f0000020 0 0
+WRITE 0 f0000021 100358 4
+RTN_EXIT 0 0 0 0
+RTN_EXIT 0 0 0 0
+RTN_EXIT 0 0 0 0
+SBLOCK_ENTER 0 1000 0 0
+WRITE 0 1001 100360 4
+RTN_CALL 0 2004 d0000000 0
+RTN_CALL 0 d0000010 e0000000 0
+RTN_CALL 0 e0000010 f0000000 0
+SBLOCK_ENTER 0 f0000020 0 0
+WRITE 0 f0000021 100368 4
+RTN_EXIT 0 0 0 0
+RTN_EXIT 0 0 0 0
+RTN_EXIT 0 0 0 0
+SBLOCK_ENTER 0 1010 0 0
+WRITE 0 1011 100370 4
+RTN_CALL 0 2005 d0000000 0
+RTN_CALL 0 d0000010 e0000000 0
+RTN_CALL 0 e0000010 f0000000 0
+SBLOCK_ENTER 0 f0000020 0 0
+WRITE 0 f0000021 100378 4
+RTN_EXIT 0 0 0 0
+RTN_EXIT 0 0 0 0
+RTN_EXIT 0 0 0 0
+SBLOCK_ENTER 0 1000 0 0
+WRITE 0 1001 100380 4
+RTN_CALL 0 2006 d0000000 0
+RTN_CALL 0 d0000010 e0000000 0
+RTN_CALL 0 e0000010 f0000000 0
+SBLOCK_ENTER 0 f0000020 0 0
+WRITE 0 f0000021 100388 4
+RTN_EXIT 0 0 0 0
+RTN_EXIT 0 0 0 0
+RTN_EXIT 0 0 0 0
+SBLOCK_ENTER 0 1010 0 0
+WRITE 0 1011 100390 4
+RTN_CALL 0 2007 d0000000 0
+RTN_CALL 0 d0000010 e0000000 0
+RTN_CALL 0 e0000010 f0000000 0
+SBLOCK_ENTER 0 f0000020 0 0
+WRITE 0 f0000021 100398 4
+RTN_EXIT 0 0 0 0
+RTN_EXIT 0 0 0 0
+RTN_EXIT 0 0 0 0
+SBLOCK_ENTER 0 1000 0 0
+WRITE 0 1001 1003a0 4
+RTN_CALL 0 2008 d0000000 0
+RTN_CALL 0 d0000010 e0000000 0
+RTN_CALL 0 e0000010 f0000000 0
+SBLOCK_ENTER 0 f0000020 0 0
+WRITE 0 f0000021 1003a8 4
+RTN_EXIT 0 0 0 0
+RTN_EXIT 0 0 0 0
+RTN_EXIT 0 0 0 0
+SBLOCK_ENTER 0 1010 0 0
+WRITE 0 1011 1003b0 4
+RTN_CALL 0 2009 d0000000 0
+RTN_CALL 0 d0000010 e0000000 0
+RTN_CALL 0 e0000010 f0000000 0
+SBLOCK_ENTER 0 f0000020 0 0
+WRITE 0 f0000021 1003b8 4
+RTN_EXIT 0 0 0 0
+RTN_EXIT 0 0 0 0
+RTN_EXIT 0 0 0 0
+SBLOCK_ENTER 0 1000 0 0
+WRITE 0 1001 1003c0 4
+RTN_CALL 0 200a d0000000 0
+RTN_CALL 0 d0000010 e0000000 0
+RTN_CALL 0 e0000010 f0000000 0
+SBLOCK_ENTER 0 f0000020 0 0
+WRITE 0 f0000021 1003c8 4
+RTN_EXIT 0 0 0 0
+RTN_EXIT 0 0 0 0
+RTN_EXIT 0 0 0 0
+SBLOCK_ENTER 0 1010 0 0
+WRITE 0 1011 1003d0 4
+RTN_CALL 0 200b d0000000 0
+RTN_CALL 0 d0000010 e0000000 0
+RTN_CALL 0 e0000010 f0000000 0
+SBLOCK_ENTER 0 f0000020 0 0
+WRITE 0 f0000021 1003d8 4
+RTN_EXIT 0 0 0 0
+RTN_EXIT 0 0 0 0
+RTN_EXIT 0 0 0 0
+SBLOCK_ENTER 0 1000 0 0
+WRITE 0 1001 1003e0 4
+RTN_CALL 0 200c d0000000 0
+RTN_CALL 0 d0000010 e0000000 0
+RTN_CALL 0 e0000010 f0000000 0
+SBLOCK_ENTER 0 f0000020 0 0
+WRITE 0 f0000021 1003e8 4
+RTN_EXIT 0 0 0 0
+RTN_EXIT 0 0 0 0
+RTN_EXIT 0 0 0 0
+SBLOCK_ENTER 0 1010 0 0
+WRITE 0 1011 1003f0 4
+RTN_CALL 0 200d d0000000 0
+RTN_CALL 0 d0000010 e0000000 0
+RTN_CALL 0 e0000010 f0000000 0
+SBLOCK_ENTER 0 f0000020 0 0
+WRITE 0 f0000021 1003f8 4
+RTN_EXIT 0 0 0 0
+RTN_EXIT 0 0 0 0
+RTN_EXIT 0 0 0 0
+SBLOCK_ENTER 0 1000 0 0
+WRITE 0 1001 100400 4
+RTN_CALL 0 200e d0000000 0
+RTN_CALL 0 d0000010 e0000000 0
+RTN_CALL 0 e0000010 f0000000 0
+SBLOCK_ENTER 0 f0000020 0 0
+WRITE 0 f0000021 100408 4
+RTN_EXIT 0 0 0 0
+RTN_EXIT 0 0 0 0
+RTN_EXIT 0 0 0 0
+SBLOCK_ENTER 0 1010 0 0
+WRITE 0 1011 100410 4
+RTN_CALL 0 200f d0000000 0
+RTN_CALL 0 d0000010 e0000000 0
+RTN_CALL 0 e0000010 f0000000 0
+SBLOCK_ENTER 0 f0000020 0 0
+WRITE 0 f0000021 100418 4
+RTN_EXIT 0 0 0 0
+RTN_EXIT 0 0 0 0
+RTN_EXIT 0 0 0 0
+SBLOCK_ENTER 0 1000 0 0
+WRITE 0 1001 100420 4
+RTN_CALL 0 2010 d0000000 0
+RTN_CALL 0 d0000010 e0000000 0
+RTN_CALL 0 e0000010 f0000000 0
+SBLOCK_ENTER 0 f0000020 0 0
+WRITE 0 f0000021 100428 4
+RTN_EXIT 0 0 0 0
+RTN_EXIT 0 0 0 0
+RTN_EXIT 0 0 0 0
+SBLOCK_ENTER 0 1010 0 0
+WRITE 0 1011 100430 4
+RTN_CALL 0 2011 d0000000 0
+RTN_CALL 0 d0000010 e0000000 0
+RTN_CALL 0 e0000010 f0000000 0
+SBLOCK_ENTER 0 f0000020 0 0
+WRITE 0 f0000021 100438 4
+RTN_EXIT 0 0 0 0
+RTN_EXIT 0 0 0 0
+RTN_EXIT 0 0 0 0
+SBLOCK_ENTER 0 1000 0 0
+WRITE 0 1001 100440 4
+RTN_CALL 0 2012 d0000000 0
+RTN_CALL 0 d0000010 e0000000 0
+RTN_CALL 0 e0000010 f0000000 0
+SBLOCK_ENTER 0 f0000020 0 0
+WRITE 0 f0000021 100448 4
+RTN_EXIT 0 0 0 0
+RTN_EXIT 0 0 0 0
+RTN_EXIT 0 0 0 0
+SBLOCK_ENTER 0 1010 0 0
+WRITE 0 1011 100450 4
+RTN_CALL 0 2013 d0000000 0
+RTN_CALL 0 d0000010 e0000000 0
+RTN_CALL 0 e0000010 f0000000 0
+SBLOCK_ENTER 0 f0000020 0 0
+WRITE 0 f0000021 100458 4
+RTN_EXIT 0 0 0 0
+RTN_EXIT 0 0 0 0
+RTN_EXIT 0 0 0 0
+SBLOCK_ENTER 0 1000 0 0
+WRITE 0 1001 100460 4
+RTN_CALL 0 2014 d0000000 0
+RTN_CALL 0 d0000010 e0000000 0
+RTN_CALL 0 e0000010 f0000000 0
+SBLOCK_ENTER 0 f0000020 0 0
+WRITE 0 f0000021 100468 4
+RTN_EXIT 0 0 0 0
+RTN_EXIT 0 0 0 0
+RTN_EXIT 0 0 0 0
+SBLOCK_ENTER 0 1010 0 0
+WRITE 0 1011 100470 4
+RTN_CALL 0 2015 d0000000 0
+RTN_CALL 0 d0000010 e0000000 0
+RTN_CALL 0 e0000010 f0000000 0
+SBLOCK_ENTER 0 f0000020 0 0
+WRITE 0 f0000021 100478 4
+RTN_EXIT 0 0 0 0
+RTN_EXIT 0 0 0 0
+RTN_EXIT 0 0 0 0
+SBLOCK_ENTER 0 1000 0 0
+WRITE 0 1001 100480 4
+RTN_CALL 0 2016 d0000000 0
+RTN_CALL 0 d0000010 e0000000 0
+RTN_CALL 0 e0000010 f0000000 0
+SBLOCK_ENTER 0 f0000020 0 0
+WRITE 0 f0000021 100488 4
+RTN_EXIT 0 0 0 0
+RTN_EXIT 0 0 0 0
+RTN_EXIT 0 0 0 0
+SBLOCK_ENTER 0 1010 0 0
+WRITE 0 1011 100490 4
+RTN_CALL 0 2017 d0000000 0
+RTN_CALL 0 d0000010 e0000000 0
+RTN_CALL 0 e0000010 f0000000 0
+SBLOCK_ENTER 0 f0000020 0 0
+WRITE 0 f0000021 100498 4
+RTN_EXIT 0 0 0 0
+RTN_EXIT 0 0 0 0
+RTN_EXIT 0 0 0 0
+SBLOCK_ENTER 0 1000 0 0
+WRITE 0 1001 1004a0 4
+RTN_CALL 0 2018 d0000000 0
+RTN_CALL 0 d0000010 e0000000 0
+RTN_CALL 0 e0000010 f0000000 0
+SBLOCK_ENTER 0 f0000020 0 0
+WRITE 0 f0000021 1004a8 4
+RTN_EXIT 0 0 0 0
+RTN_EXIT 0 0 0 0
+RTN_EXIT 0 0 0 0
+SBLOCK_ENTER 0 1010 0 0
+WRITE 0 1011 1004b0 4
+RTN_CALL 0 2019 d0000000 0
+RTN_CALL 0 d0000010 e0000000 0
+RTN_CALL 0 e0000010 f0000000 0
+SBLOCK_ENTER 0 f0000020 0 0
+WRITE 0 f0000021 1004b8 4
+RTN_EXIT 0 0 0 0
+RTN_EXIT 0 0 0 0
+RTN_EXIT 0 0 0 0
+SBLOCK_ENTER 0 1000 0 0
+WRITE 0 1001 1004c0 4
+RTN_CALL 0 201a d0000000 0
+RTN_CALL 0 d0000010 e0000000 0
+RTN_CALL 0 e0000010 f0000000 0
+SBLOCK_ENTER 0 f0000020 0 0
+WRITE 0 f0000021 1004c8 4
+RTN_EXIT 0 0 0 0
+RTN_EXIT 0 0 0 0
+RTN_EXIT 0 0 0 0
+SBLOCK_ENTER 0 1010 0 0
+WRITE 0 1011 1004d0 4
+RTN_CALL 0 201b d0000000 0
+RTN_CALL 0 d0000010 e0000000 0
+RTN_CALL 0 e0000010 f0000000 0
+SBLOCK_ENTER 0 f0000020 0 0
+WRITE 0 f0000021 1004d8 4
+RTN_EXIT 0 0 0 0
+RTN_EXIT 0 0 0 0
+RTN_EXIT 0 0 0 0
+SBLOCK_ENTER 0 1000 0 0
+WRITE 0 1001 1004e0 4
+RTN_CALL 0 201c d0000000 0
+RTN_CALL 0 d0000010 e0000000 0
+RTN_CALL 0 e0000010 f0000000 0
+SBLOCK_ENTER 0 f0000020 0 0
+WRITE 0 f0000021 1004e8 4
+RTN_EXIT 0 0 0 0
+RTN_EXIT 0 0 0 0
+RTN_EXIT 0 0 0 0
+SBLOCK_ENTER 0 1010 0 0
+WRITE 0 1011 1004f0 4
+RTN_CALL 0 201d d0000000 0
+RTN_CALL 0 d0000010 e0000000 0
+RTN_CALL 0 e0000010 f0000000 0
+SBLOCK_ENTER 0 f0000020 0 0
+WRITE 0 f0000021 1004f8 4
+RTN_EXIT 0 0 0 0
+RTN_EXIT 0 0 0 0
+RTN_EXIT 0 0 0 0
+SBLOCK_ENTER 0 1000 0 0
+WRITE 0 1001 100500 4
+RTN_CALL 0 201e d0000000 0
+RTN_CALL 0 d0000010 e0000000 0
+RTN_CALL 0 e0000010 f0000000 0
+SBLOCK_ENTER 0 f0000020 0 0
+WRITE 0 f0000021 100508 4
+RTN_EXIT 0 0 0 0
+RTN_EXIT 0 0 0 0
+RTN_EXIT 0 0 0 0
+SBLOCK_ENTER 0 1010 0 0
+WRITE 0 1011 100510 4
+RTN_CALL 0 201f d0000000 0
+RTN_CALL 0 d0000010 e0000000 0
+RTN_CALL 0 e0000010 f0000000 0
+SBLOCK_ENTER 0 f0000020 0 0
+WRITE 0 f0000021 100518 4
+RTN_EXIT 0 0 0 0
+RTN_EXIT 0 0 0 0
+RTN_EXIT 0 0 0 0
+SBLOCK_ENTER 0 1000 0 0
+WRITE 0 1001 100520 4
+RTN_CALL 0 2020 d0000000 0
+RTN_CALL 0 d0000010 e0000000 0
+RTN_CALL 0 e0000010 f0000000 0
+SBLOCK_ENTER 0 f0000020 0 0
+WRITE 0 f0000021 100528 4
+RTN_EXIT 0 0 0 0
+RTN_EXIT 0 0 0 0
+RTN_EXIT 0 0 0 0
+SBLOCK_ENTER 0 1010 0 0
+WRITE 0 1011 100530 4
+RTN_CALL 0 2021 d0000000 0
+RTN_CALL 0 d0000010 e0000000 0
+RTN_CALL 0 e0000010 f0000000 0
+SBLOCK_ENTER 0 f0000020 0 0
+WRITE 0 f0000021 100538 4
+RTN_EXIT 0 0 0 0
+RTN_EXIT 0 0 0 0
+RTN_EXIT 0 0 0 0
+SBLOCK_ENTER 0 1000 0 0
+WRITE 0 1001 100540 4
+RTN_CALL 0 2022 d0000000 0
+RTN_CALL 0 d0000010 e0000000 0
+RTN_CALL 0 e0000010 f0000000 0
+SBLOCK_ENTER 0 f0000020 0 0
+WRITE 0 f0000021 100548 4
+RTN_EXIT 0 0 0 0
+RTN_EXIT 0 0 0 0
+RTN_EXIT 0 0 0 0
+SBLOCK_ENTER 0 1010 0 0
+WRITE 0 1011 100550 4
+RTN_CALL 0 2023 d0000000 0
+RTN_CALL 0 d0000010 e0000000 0
+RTN_CALL 0 e0000010 f0000000 0
+SBLOCK_ENTER 0 f0000020 0 0
+WRITE 0 f0000021 100558 4
+RTN_EXIT 0 0 0 0
+RTN_EXIT 0 0 0 0
+RTN_EXIT 0 0 0 0
+SBLOCK_ENTER 0 1000 0 0
+WRITE 0 1001 100560 4
+RTN_CALL 0 2024 d0000000 0
+RTN_CALL 0 d0000010 e0000000 0
+RTN_CALL 0 e0000010 f0000000 0
+SBLOCK_ENTER 0 f0000020 0 0
+WRITE 0 f0000021 100568 4
+RTN_EXIT 0 0 0 0
+RTN_EXIT 0 0 0 0
+RTN_EXIT 0 0 0 0
+SBLOCK_ENTER 0 1010 0 0
+WRITE 0 1011 100570 4
+RTN_CALL 0 2025 d0000000 0
+RTN_CALL 0 d0000010 e0000000 0
+RTN_CALL 0 e0000010 f0000000 0
+SBLOCK_ENTER 0 f0000020 0 0
+WRITE 0 f0000021 100578 4
+RTN_EXIT 0 0 0 0
+RTN_EXIT 0 0 0 0
+RTN_EXIT 0 0 0 0
+SBLOCK_ENTER 0 1000 0 0
+WRITE 0 1001 100580 4
+RTN_CALL 0 2026 d0000000 0
+RTN_CALL 0 d0000010 e0000000 0
+RTN_CALL 0 e0000010 f0000000 0
+SBLOCK_ENTER 0 f0000020 0 0
+WRITE 0 f0000021 100588 4
+RTN_EXIT 0 0 0 0
+RTN_EXIT 0 0 0 0
+RTN_EXIT 0 0 0 0
+SBLOCK_ENTER 0 1010 0 0
+WRITE 0 1011 100590 4
+RTN_CALL 0 2027 d0000000 0
+RTN_CALL 0 d0000010 e0000000 0
+RTN_CALL 0 e0000010 f0000000 0
+SBLOCK_ENTER 0 f0000020 0 0
+WRITE 0 f0000021 100598 4
+RTN_EXIT 0 0 0 0
+RTN_EXIT 0 0 0 0
+RTN_EXIT 0 0 0 0
+SBLOCK_ENTER 0 1000 0 0
+WRITE 0 1001 1005a0 4
+RTN_CALL 0 2028 d0000000 0
+RTN_CALL 0 d0000010 e0000000 0
+RTN_CALL 0 e0000010 f0000000 0
+SBLOCK_ENTER 0 f0000020 0 0
+WRITE 0 f0000021 1005a8 4
+RTN_EXIT 0 0 0 0
+RTN_EXIT 0 0 0 0
+RTN_EXIT 0 0 0 0
+SBLOCK_ENTER 0 1010 0 0
+WRITE 0 1011 1005b0 4
+RTN_CALL 0 2029 d0000000 0
+RTN_CALL 0 d0000010 e0000000 0
+RTN_CALL 0 e0000010 f0000000 0
+SBLOCK_ENTER 0 f0000020 0 0
+WRITE 0 f0000021 1005b8 4
+RTN_EXIT 0 0 0 0
+RTN_EXIT 0 0 0 0
+RTN_EXIT 0 0 0 0
+SBLOCK_ENTER 0 1000 0 0
+WRITE 0 1001 1005c0 4
+RTN_CALL 0 202a d0000000 0
+RTN_CALL 0 d0000010 e0000000 0
+RTN_CALL 0 e0000010 f0000000 0
+SBLOCK_ENTER 0 f0000020 0 0
+WRITE 0 f0000021 1005c8 4
+RTN_EXIT 0 0 0 0
+RTN_EXIT 0 0 0 0
+RTN_EXIT 0 0 0 0
+SBLOCK_ENTER 0 1010 0 0
+WRITE 0 1011 1005d0 4
+RTN_CALL 0 202b d0000000 0
+RTN_CALL 0 d0000010 e0000000 0
+RTN_CALL 0 e0000010 f0000000 0
+SBLOCK_ENTER 0 f0000020 0 0
+WRITE 0 f0000021 1005d8 4
+RTN_EXIT 0 0 0 0
+RTN_EXIT 0 0 0 0
+RTN_EXIT 0 0 0 0
+SBLOCK_ENTER 0 1000 0 0
+WRITE 0 1001 1005e0 4
+RTN_CALL 0 202c d0000000 0
+RTN_CALL 0 d0000010 e0000000 0
+RTN_CALL 0 e0000010 f0000000 0
+SBLOCK_ENTER 0 f0000020 0 0
+WRITE 0 f0000021 1005e8 4
+RTN_EXIT 0 0 0 0
+RTN_EXIT 0 0 0 0
+RTN_EXIT 0 0 0 0
+SBLOCK_ENTER 0 1010 0 0
+WRITE 0 1011 1005f0 4
+RTN_CALL 0 202d d0000000 0
+RTN_CALL 0 d0000010 e0000000 0
+RTN_CALL 0 e0000010 f0000000 0
+SBLOCK_ENTER 0 f0000020 0 0
+WRITE 0 f0000021 1005f8 4
+RTN_EXIT 0 0 0 0
+RTN_EXIT 0 0 0 0
+RTN_EXIT 0 0 0 0
+SBLOCK_ENTER 0 1000 0 0
+WRITE 0 1001 100600 4
+RTN_CALL 0 202e d0000000 0
+RTN_CALL 0 d0000010 e0000000 0
+RTN_CALL 0 e0000010 f0000000 0
+SBLOCK_ENTER 0 f0000020 0 0
+WRITE 0 f0000021 100608 4
+RTN_EXIT 0 0 0 0
+RTN_EXIT 0 0 0 0
+RTN_EXIT 0 0 0 0
+SBLOCK_ENTER 0 1010 0 0
+WRITE 0 1011 100610 4
+RTN_CALL 0 202f d0000000 0
+RTN_CALL 0 d0000010 e0000000 0
+RTN_CALL 0 e0000010 f0000000 0
+SBLOCK_ENTER 0 f0000020 0 0
+WRITE 0 f0000021 100618 4
+RTN_EXIT 0 0 0 0
+RTN_EXIT 0 0 0 0
+RTN_EXIT 0 0 0 0
+SBLOCK_ENTER 0 1000 0 0
+WRITE 0 1001 100620 4
+RTN_CALL 0 2030 d0000000 0
+RTN_CALL 0 d0000010 e0000000 0
+RTN_CALL 0 e0000010 f0000000 0
+SBLOCK_ENTER 0 f0000020 0 0
+WRITE 0 f0000021 100628 4
+RTN_EXIT 0 0 0 0
+RTN_EXIT 0 0 0 0
+RTN_EXIT 0 0 0 0
+SBLOCK_ENTER 0 1010 0 0
+WRITE 0 1011 100630 4
+RTN_CALL 0 2031 d0000000 0
+RTN_CALL 0 d0000010 e0000000 0
+RTN_CALL 0 e0000010 f0000000 0
+SBLOCK_ENTER 0 f0000020 0 0
+WRITE 0 f0000021 100638 4
+RTN_EXIT 0 0 0 0
+RTN_EXIT 0 0 0 0
+RTN_EXIT 0 0 0 0
+RTN_EXIT 0 0 0 0
+THR_END 1 0 0 0
+THR_END 0 0 0 0
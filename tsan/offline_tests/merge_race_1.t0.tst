@@ -0,0 +1,14 @@
+# Events of thread T0 for the merge example (see merge_race_1.t1.tst).
+# Run: ts_offline --input_type=merge \
+#        --merge_input=merge_race_1.t0.tst --merge_input=merge_race_1.t1.tst
+# Events prefixed with @seq are ordered across the files by seq.
+@1 THR_START 0 0 0 0
+LOCK_CREATE 0 ff0 7777 0
+LOCK_CREATE 0 ff1 7778 0
+MALLOC 0 cdeffedc abcd0 ff
+
+# Acquire lock 7777 in T0 and write to 0xabcde.
+@3 WRITER_LOCK 0 aa 7777 0
+SBLOCK_ENTER 0 ca000003 0 0
+WRITE 0 aa008001 abcde 1
+@4 UNLOCK 0 ab 7777 0
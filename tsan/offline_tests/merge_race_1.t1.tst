@@ -0,0 +1,8 @@
+# Events of thread T1 for the merge example (see merge_race_1.t0.tst).
+@2 THR_START 1 0 0 0
+
+# Acquire a different lock: the read below races with the write in T0.
+@5 READER_LOCK 1 bb 7778 0
+SBLOCK_ENTER 1 ca100003 0 0
+READ 1 aa108001 abcde 1
+@6 UNLOCK 1 bc 7778 0
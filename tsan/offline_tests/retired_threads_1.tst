@@ -0,0 +1,30 @@
+THR_START 0 0 0 0
+# T1 is joined before T2 and T3 start, it is retired in generation 1.
+THR_CREATE_BEFORE 0 0 0 0
+THR_START 1 0 0 0
+THR_CREATE_AFTER 0 0 0 1
+SBLOCK_ENTER 1 1000 0 0
+WRITE 1 1001 abcd0 4
+THR_END 1 0 0 0
+THR_JOIN_AFTER 0 0 1 0
+THR_CREATE_BEFORE 0 0 0 0
+THR_START 2 0 0 0
+THR_CREATE_AFTER 0 0 0 2
+THR_CREATE_BEFORE 0 0 0 0
+THR_START 3 0 0 0
+THR_CREATE_AFTER 0 0 0 3
+# No race: the VTS of T2 has no entry for T1 and implies its final clock.
+SBLOCK_ENTER 2 2000 0 0
+WRITE 2 2001 abcd0 4
+SBLOCK_ENTER 3 3000 0 0
+WRITE 3 3001 abcd8 4
+THR_END 3 0 0 0
+# T3 is retired in generation 2, T0 now implies its final clock.
+THR_JOIN_AFTER 0 0 3 0
+SBLOCK_ENTER 0 4000 0 0
+WRITE 0 4001 abcd10 4
+# Race: T2 (generation 1) has not synchronized with T3 nor with T0.
+WRITE 2 2002 abcd10 4
+THR_END 2 0 0 0
+THR_JOIN_AFTER 0 0 2 0
+THR_END 0 0 0 0
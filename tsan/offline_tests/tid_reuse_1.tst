@@ -0,0 +1,18 @@
+THR_START 0 0 0 0
+THR_CREATE_BEFORE 0 0 0 0
+THR_START 1 0 0 0
+THR_CREATE_AFTER 0 0 0 1
+SBLOCK_ENTER 1 1000 0 0
+WRITE 1 1001 abcd0 4
+THR_END 1 0 0 0
+THR_JOIN_AFTER 0 0 1 0
+SBLOCK_ENTER 0 2000 0 0
+# T0 does not touch abcd0, so the old segment of T1 is still alive.
+THR_CREATE_BEFORE 0 0 0 0
+THR_START 1 0 0 0
+THR_CREATE_AFTER 0 0 0 1
+SBLOCK_ENTER 1 3000 0 0
+WRITE 1 3001 abcd0 4
+THR_END 1 0 0 0
+THR_JOIN_AFTER 0 0 1 0
+THR_END 0 0 0 0
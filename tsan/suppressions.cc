@@ -335,6 +335,10 @@ ThreadSanitizerSuppressions::~ThreadSanitizerSuppressions() {
   delete rep_;
 }
 
+void ThreadSanitizerSuppressions::Clear() {
+  rep_->suppressions.clear();
+}
+
 int ThreadSanitizerSuppressions::ReadFromString(const string &str) {
   int sizeBefore = rep_->suppressions.size();
   ThreadSanitizerParser* parser = new ThreadSanitizerParser(str);
@@ -45,6 +45,9 @@ class ThreadSanitizerSuppressions {
   // Return the number of parsed suppressions or -1 if an error occured.
   int ReadFromString(const string &str);
 
+  // Forget all suppressions read so far.
+  void Clear();
+
   // Returns the string describing the last error. Undefined if there was no
   // error.
   string GetErrorString();
@@ -98,6 +98,14 @@ TEST_F(SuppressionsTest, OnlyMatchesAtTheTop) {
   ASSERT_FALSE(IsSuppressed(VEC(m), VEC(d), VEC(o)));
 }
 
+TEST_F(SuppressionsTest, Clear) {
+  string m[] = {"function1", "bb", "function2"};
+  string d[] = {"aaa", "bbb", "ccc"};
+  string o[] = {"object2", "object1", "object3"};
+  supp_.Clear();
+  ASSERT_FALSE(IsSuppressed(VEC(m), VEC(d), VEC(o)));
+}
+
 // A short stack trace is not.
 TEST_F(SuppressionsTest, ShortTrace) {
   string m[] = {"function1", "bb"};
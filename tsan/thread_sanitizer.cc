@@ -299,6 +299,8 @@ static void FlushStateIfOutOfSegments(TSanThread *thr);
 static int32_t raw_tid(TSanThread *t);
 // -------- Simple Cache ------ {{{1
 #include "ts_simple_cache.h"
+// -------- Retired threads ------ {{{1
+#include "ts_retired_threads.h"
 // -------- PairCache & IntPairToIntCache ------ {{{1
 template <typename A, typename B, typename Ret,
          int kHtableSize, int kArraySize = 8>
@@ -910,7 +912,7 @@ class LockSet {
     return true;
   }
 
-  NOINLINE static bool IntersectionIsEmpty(LSID lsid1, LSID lsid2) {
+  static INLINE bool IntersectionIsEmpty(LSID lsid1, LSID lsid2) {
     // at least one empty
     if (lsid1.IsEmpty() || lsid2.IsEmpty())
       return true;  // empty
@@ -920,6 +922,16 @@ class LockSet {
       return lsid1 != lsid2;
     }
 
+    // Disjoint signatures mean disjoint lock sets.
+    if ((Signature(lsid1) & Signature(lsid2)) == 0) {
+      G_stats->ls_intersection_fast++;
+      return true;
+    }
+    G_stats->ls_intersection_exact++;
+    return IntersectionIsEmptySlow(lsid1, lsid2);
+  }
+
+  NOINLINE static bool IntersectionIsEmptySlow(LSID lsid1, LSID lsid2) {
     // first is singleton, second is not
     if (lsid1.IsSingleton()) {
       const LSSet &set2 = Get(lsid2);
@@ -948,16 +960,24 @@ class LockSet {
     const LSSet &set1 = Get(lsid1);
     const LSSet &set2 = Get(lsid2);
 
-    FixedArray<LID> intersection(min(set1.size(), set2.size()));
-    LID *end = set_intersection(set1.begin(), set1.end(),
-                            set2.begin(), set2.end(),
-                            intersection.begin());
-    DCHECK(!cache_hit || (ret == (end == intersection.begin())));
-    ret = (end == intersection.begin());
+    DCHECK(!cache_hit || (ret == !set1.Intersects(set2)));
+    ret = !set1.Intersects(set2);
     ls_intersection_cache_->Insert(lsid1.raw(), -lsid2.raw(), ret);
     return ret;
   }
 
+  // Two lock sets with disjoint signatures are disjoint.
+  // The signature of the empty lock set is 0.
+  static INLINE uint64_t Signature(LSID lsid) {
+    if (lsid.IsEmpty())
+      return 0;
+    if (lsid.IsSingleton())
+      return LockSignature(lsid.GetSingleton());
+    int idx = -lsid.raw() - 1;
+    DCHECK(idx < static_cast<int>(sig_vec_->size()));
+    return (*sig_vec_)[idx];
+  }
+
   static bool HasNonPhbLocks(LSID lsid) {
     if (lsid.IsEmpty())
       return false;
@@ -1024,6 +1044,7 @@ class LockSet {
   static void InitClassMembers() {
     map_ = new LockSet::Map;
     vec_ = new LockSet::Vec;
+    sig_vec_ = new vector<uint64_t>;
     ls_add_cache_ = new LSCache;
     ls_rem_cache_ = new LSCache;
     ls_rem_cache_ = new LSCache;
@@ -1034,7 +1055,13 @@ class LockSet {
   // No instances are allowed.
   LockSet() { }
 
-  typedef DenseMultimap<LID, 3> LSSet;
+  // Lock sets of up to 8 locks fit into one cache line.
+  typedef DenseMultimap<LID, 8> LSSet;
+
+  // A 64-bit signature of a lock set: bit (lid % 64) is set for every lock.
+  static INLINE uint64_t LockSignature(LID lid) {
+    return (uint64_t)1 << (lid.raw() & 63);
+  }
 
   static LSSet &Get(LSID lsid) {
     ScopedMallocCostCenter cc(__FUNCTION__);
@@ -1057,6 +1084,10 @@ class LockSet {
     int32_t *id = &(*map_)[set];
     if (*id == 0) {
       vec_->push_back(set);
+      uint64_t signature = 0;
+      for (LSSet::const_iterator it = set.begin(); it != set.end(); ++it)
+        signature |= LockSignature(*it);
+      sig_vec_->push_back(signature);
       *id = map_->size();
       if      (set.size() == 2) G_stats->ls_size_2++;
       else if (set.size() == 3) G_stats->ls_size_3++;
@@ -1082,6 +1113,8 @@ class LockSet {
   static const char *kLockSetVecAllocCC;
   typedef vector<LSSet> Vec;
   static Vec *vec_;
+  // Signatures of the lock sets in vec_.
+  static vector<uint64_t> *sig_vec_;
 
 //  static const int kPrimeSizeOfLsCache = 307;
 //  static const int kPrimeSizeOfLsCache = 499;
@@ -1096,6 +1129,7 @@ class LockSet {
 
 LockSet::Map *LockSet::map_;
 LockSet::Vec *LockSet::vec_;
+vector<uint64_t> *LockSet::sig_vec_;
 const char *LockSet::kLockSetVecAllocCC = "kLockSetVecAllocCC";
 LockSet::LSCache *LockSet::ls_add_cache_;
 LockSet::LSCache *LockSet::ls_rem_cache_;
@@ -1179,6 +1213,17 @@ class VTS {
     return res;
   }
 
+  // Same as CreateSingleton(), but the new VTS also covers the final clocks
+  // of all retired threads. Used by ForgetAllState(), after which the
+  // history of the dead threads is gone anyway.
+  static VTS *CreateSingletonAfterFlush(TID tid, int32_t clk) {
+    int32_t gen = NumberOfRetiredThreads();
+    // An explicit entry must exceed the implied one.
+    VTS *res = CreateSingleton(tid, max(clk, ImplicitClk(tid.raw(), gen) + 1));
+    res->gen_ = gen;
+    return res;
+  }
+
   VTS *Clone() {
     G_stats->vts_clone++;
     AtomicIncrementRefcount(&ref_count_);
@@ -1188,6 +1233,7 @@ class VTS {
   static VTS *CopyAndTick(const VTS *vts, TID id_to_tick) {
     CHECK(vts->ref_count_);
     VTS *res = Create(vts->size());
+    res->gen_ = vts->gen_;
     bool found = false;
     for (size_t i = 0; i < res->size(); i++) {
       res->arr_[i] = vts->arr_[i];
@@ -1240,7 +1286,17 @@ class VTS {
       t++;
     }
 
-    VTS *res = VTS::Create(t - result_ts.begin());
+    size_t n = t - result_ts.begin();
+    int32_t gen = max(vts_a->gen_, vts_b->gen_);
+    if (UNLIKELY(gen < NumberOfRetiredThreads())) {
+      gen = AdvanceGeneration(result_ts.begin(), n, gen);
+    }
+    if (gen > 0) {
+      n = RemoveRetiredEntries(result_ts.begin(), n, gen);
+    }
+
+    VTS *res = VTS::Create(n);
+    res->gen_ = gen;
     for (size_t i = 0; i < res->size(); i++) {
       res->arr_[i] = result_ts[i];
     }
@@ -1255,7 +1311,39 @@ class VTS {
         return arr_[i].clk;
       }
     }
-    return 0;
+    return ImplicitClk(tid.raw(), gen_);
+  }
+
+  // Dead thread compaction.
+  // Once a thread has ended and has been joined, its final clock never
+  // changes. Such a thread is "retired": it gets the next generation number
+  // and its final clock is remembered. A VTS of generation G covers the
+  // final clocks of the threads retired in generations 1..G, so their
+  // entries are dropped from it and a missing entry for such a thread
+  // means "the final clock" instead of 0.
+  // Join() takes the max generation of its arguments and advances it while
+  // the result contains the final clocks of the next retired threads.
+  // This keeps the size of a VTS proportional to the number of live threads.
+  //
+  // RetireThread() must be called under ts_lock. The table of retired
+  // threads is read without it (e.g. by HappensBefore() on the lock-free
+  // path), see RetiredThreads. Once the table is full the threads are
+  // no longer retired and keep their explicit entries.
+  static void RetireThread(TID tid, int32_t final_clk) {
+    AssertTILHeld();
+    if (!retired_->Retire(tid.raw(), final_clk)) {
+      if (G_stats->vts_retire_failed++ == 0) {
+        Report("INFO: the table of retired threads is full; "
+               "the clocks of the threads ending from now on "
+               "will not be compacted\n");
+      }
+      return;
+    }
+    G_stats->vts_retired_threads++;
+  }
+
+  static int32_t NumberOfRetiredThreads() {
+    return retired_->size();
   }
 
   static INLINE void FlushHBCache() {
@@ -1279,6 +1367,11 @@ class VTS {
     CHECK(vts_a->ref_count_);
     CHECK(vts_b->ref_count_);
     G_stats->n_vts_hb++;
+    if (UNLIKELY(vts_a->gen_ != vts_b->gen_)) {
+      return HappensBeforeAcrossGenerations(vts_a, vts_b);
+    }
+    // Both VTSs cover the same retired threads, so every entry missing
+    // in one of them is compared as 0.
     const TS *a = &vts_a->arr_[0];
     const TS *b = &vts_b->arr_[0];
     const TS *a_max = a + vts_a->size();
@@ -1310,6 +1403,50 @@ class VTS {
     return a_less_than_b;
   }
 
+  // Slow path of HappensBefore() for VTSs of different generations.
+  // A missing entry is compared as the thread's clock implied by
+  // the generation of the VTS.
+  static NOINLINE bool HappensBeforeAcrossGenerations(const VTS *vts_a,
+                                                      const VTS *vts_b) {
+    G_stats->n_vts_hb_across_gen++;
+    bool a_less_than_b = false;
+    // Threads retired between the two generations may be missing
+    // from both arrays.
+    int32_t gen_min = min(vts_a->gen_, vts_b->gen_);
+    int32_t gen_max = max(vts_a->gen_, vts_b->gen_);
+    for (int32_t g = gen_min; g < gen_max; g++) {
+      TID tid(retired_->Get(g + 1).tid);
+      int32_t a_clk = vts_a->clk(tid);
+      int32_t b_clk = vts_b->clk(tid);
+      if (a_clk > b_clk) return false;
+      if (a_clk < b_clk) a_less_than_b = true;
+    }
+    const TS *a = &vts_a->arr_[0];
+    const TS *b = &vts_b->arr_[0];
+    const TS *a_max = a + vts_a->size();
+    const TS *b_max = b + vts_b->size();
+    while (a < a_max || b < b_max) {
+      int32_t a_clk, b_clk;
+      if (b == b_max || (a < a_max && a->tid < b->tid)) {
+        a_clk = a->clk;
+        b_clk = ImplicitClk(a->tid, vts_b->gen_);
+        a++;
+      } else if (a == a_max || a->tid > b->tid) {
+        a_clk = ImplicitClk(b->tid, vts_a->gen_);
+        b_clk = b->clk;
+        b++;
+      } else {
+        a_clk = a->clk;
+        b_clk = b->clk;
+        a++;
+        b++;
+      }
+      if (a_clk > b_clk) return false;
+      if (a_clk < b_clk) a_less_than_b = true;
+    }
+    return a_less_than_b;
+  }
+
   size_t size() const {
     DCHECK(ref_count_);
     return size_;
@@ -1324,6 +1461,11 @@ class VTS {
       if (i) res += " ";
       res += buff;
     }
+    if (gen_) {
+      char buff[100];
+      snprintf(buff, sizeof(buff), " gen:%d", gen_);
+      res += buff;
+    }
     return res + "]";
   }
 
@@ -1406,6 +1548,8 @@ class VTS {
 
   static void InitClassMembers() {
     hb_cache_ = new HBCache;
+    retired_ = new RetiredThreads(G_flags->max_n_threads,
+                                  kRetiredChunkSize, kMaxRetiredChunks);
     free_lists_ = new FreeList *[kNumberOfFreeLists+1];
     free_lists_[0] = 0;
     for (size_t  i = 1; i <= kNumberOfFreeLists; i++) {
@@ -1419,6 +1563,7 @@ class VTS {
  private:
   explicit VTS(size_t size)
     : ref_count_(1),
+      gen_(0),
       size_(size) {
     uniq_id_counter_++;
     // If we've got overflow, we are in trouble, need to have 64-bits...
@@ -1432,28 +1577,72 @@ class VTS {
     int32_t clk;
   };
 
+  // Clock of |tid| implied by a VTS of generation |gen| with no entry for it.
+  static int32_t ImplicitClk(int32_t tid, int32_t gen) {
+    return retired_->ImplicitClk(tid, gen);
+  }
+
+  static const TS *FindTS(const TS *arr, size_t n, int32_t tid) {
+    size_t lo = 0, hi = n;
+    while (lo < hi) {
+      size_t mid = (lo + hi) / 2;
+      if (arr[mid].tid < tid) lo = mid + 1;
+      else hi = mid;
+    }
+    return (lo < n && arr[lo].tid == tid) ? &arr[lo] : NULL;
+  }
+
+  // Return the largest generation not less than |gen| covered by
+  // the sorted array |arr|.
+  static int32_t AdvanceGeneration(const TS *arr, size_t n, int32_t gen) {
+    while (gen < NumberOfRetiredThreads()) {
+      const RetiredThreads::Entry &r = retired_->Get(gen + 1);
+      const TS *ts = FindTS(arr, n, r.tid);
+      if (!ts || ts->clk < r.clk) break;
+      gen++;
+    }
+    return gen;
+  }
+
+  // Drop the entries implied by generation |gen|. Return the new size.
+  static size_t RemoveRetiredEntries(TS *arr, size_t n, int32_t gen) {
+    size_t res = 0;
+    for (size_t i = 0; i < n; i++) {
+      if (arr[i].clk <= ImplicitClk(arr[i].tid, gen)) continue;
+      arr[res++] = arr[i];
+    }
+    G_stats->vts_retired_entries_removed += n - res;
+    return res;
+  }
 
   // data members
   int32_t ref_count_;
   int32_t uniq_id_;
-  size_t size_;
+  int32_t gen_;  // Number of retired threads covered by this VTS.
+  uint32_t size_;
   TS     arr_[];  // array of size_ elements.
 
 
   // static data members
   static int32_t uniq_id_counter_;
-  static const int kCacheSize = 4999;  // Has to be prime.
-  typedef IntPairToBoolCache<kCacheSize> HBCache;
+  static const int kCacheShards = 8;
+  static const int kCacheShardSize = 1021;  // Has to be prime.
+  typedef ConcurrentIntPairToBoolCache<kCacheShards, kCacheShardSize> HBCache;
   static HBCache *hb_cache_;
 
   static const size_t kNumberOfFreeLists = 512;  // Must be power of two.
 //  static const size_t kNumberOfFreeLists = 64; // Must be power of two.
   static FreeList **free_lists_;  // Array of kNumberOfFreeLists elements.
+
+  static const size_t kRetiredChunkSize = 1 << 16;
+  static const size_t kMaxRetiredChunks = 1 << 12;
+  static RetiredThreads *retired_;
 };
 
 int32_t VTS::uniq_id_counter_;
 VTS::HBCache *VTS::hb_cache_;
 FreeList **VTS::free_lists_;
+RetiredThreads *VTS::retired_;
 
 
 // This class is somewhat similar to VTS,
@@ -1818,6 +2007,7 @@ class Segment {
     if (kSizeOfHistoryStackTrace) {
       embedded_stack_trace(sid)[0] = 0;
     }
+    AtomicIncrementRefcount(&n_live_segments_[tid.raw()]);
   }
 
   static INLINE SID AddNewSegment(TID tid, VTS *vts,
@@ -1875,6 +2065,7 @@ class Segment {
     DCHECK(sid.raw() < n_segments_);
     if (!seg->vts()) return false;  // Already recycled.
     VTS::Unref(seg->vts_);
+    AtomicDecrementRefcount(&n_live_segments_[seg->tid_.raw()]);
     RecycleOneFreshSid(sid);
     return true;
   }
@@ -1883,6 +2074,12 @@ class Segment {
     return INTERNAL_ANNOTATE_UNPROTECTED_READ(seg_ref_count_);
   }
 
+  // Number of segments of the thread that have been set up
+  // and not recycled yet.
+  static int32_t NumberOfLiveSegments(TID tid) {
+    return INTERNAL_ANNOTATE_UNPROTECTED_READ(n_live_segments_[tid.raw()]);
+  }
+
   static void INLINE Ref(SID sid, const char *where) {
     Segment *seg = GetInternal(sid);
     if (ProfileSeg(sid)) {
@@ -1912,6 +2109,7 @@ class Segment {
   static void ForgetAllState() {
     n_segments_ = 1;
     reusable_sids_->clear();
+    memset(n_live_segments_, 0, sizeof(int32_t) * G_flags->max_n_threads);
     // vts_'es will be freed in AddNewSegment.
   }
 
@@ -1993,9 +2191,10 @@ class Segment {
       }
     }
 
-    all_segments_  = new Segment[kMaxSID];
-    // initialization all segments to 0.
-    memset(all_segments_, 0, kMaxSID * sizeof(Segment));
+    // All segments are initialized to 0. The table is mapped lazily,
+    // so the segments that are never used cost nothing.
+    all_segments_ = static_cast<Segment*>(
+        AllocateZeroedTable(kMaxSID * sizeof(Segment)));
     // initialize all_segments_[0] with garbage
     memset(all_segments_, -1, sizeof(Segment));
 
@@ -2008,6 +2207,8 @@ class Segment {
     }
     n_segments_    = 1;
     reusable_sids_ = new vector<SID>;
+    n_live_segments_ = new int32_t[G_flags->max_n_threads];
+    memset(n_live_segments_, 0, sizeof(int32_t) * G_flags->max_n_threads);
   }
 
  private:
@@ -2045,6 +2246,8 @@ class Segment {
 
   static int32_t n_segments_;
   static vector<SID> *reusable_sids_;
+  // Indexed by tid, see NumberOfLiveSegments().
+  static int32_t *n_live_segments_;
 };
 
 Segment          *Segment::all_segments_;
@@ -2052,6 +2255,7 @@ uintptr_t       **Segment::all_stacks_;
 size_t            Segment::n_stack_chunks_;
 int32_t           Segment::n_segments_;
 vector<SID>      *Segment::reusable_sids_;
+int32_t          *Segment::n_live_segments_;
 
 // -------- SegmentSet -------------- {{{1
 class SegmentSet {
@@ -2277,14 +2481,7 @@ class SegmentSet {
       return false;
     }
 
-    SegmentSet *ss = Get(ssid);
-    for (int i = 0; i < kMaxSegmentSetSize; i++) {
-      SID sid = ss->GetSID(i);
-      if (sid.raw() == 0) break;
-      if (sid == seg)
-        return true;
-    }
-    return false;
+    return Get(ssid)->MatchSID(seg) != 0;
   }
 
   static Segment *GetSegmentForNonSingleton(SSID ssid, int32_t i, int line) {
@@ -2309,12 +2506,32 @@ class SegmentSet {
   SegmentSet()  // Private CTOR
     : ref_count_(0) {
     // sids_ are filled with zeroes due to SID default CTOR.
+    for (int i = 0; i < kMaxSegmentSetSize; i++)
+      tids_[i] = TID::kInvalidTID;
     if (TSAN_DEBUG) {
       for (int i = 0; i < kMaxSegmentSetSize; i++)
         CHECK_EQ(sids_[i].raw(), 0);
     }
   }
 
+  // Bit i of the result is set if sids_[i] == sid.
+  // Unused slots hold SID(0) and never match.
+  INLINE uint32_t MatchSID(SID sid) const {
+    uint32_t res = 0;
+    for (int i = 0; i < kMaxSegmentSetSize; i++)
+      res |= (uint32_t)(sids_[i].raw() == sid.raw()) << i;
+    return res;
+  }
+
+  // Bit i of the result is set if sids_[i] belongs to thread 'tid'.
+  // Unused slots hold an invalid TID and never match.
+  INLINE uint32_t MatchTID(TID tid) const {
+    uint32_t res = 0;
+    for (int i = 0; i < kMaxSegmentSetSize; i++)
+      res |= (uint32_t)(tids_[i] == tid.raw()) << i;
+    return res;
+  }
+
   int size() const {
     for (int i = 0; i < kMaxSegmentSetSize; i++) {
       if (sids_[i].raw() == 0) {
@@ -2341,6 +2558,7 @@ class SegmentSet {
       G_stats->ss_reuse++;
       for (int i = 0; i < kMaxSegmentSetSize; i++) {
         res_ss->sids_[i] = SID(0);
+        res_ss->tids_[i] = TID::kInvalidTID;
       }
     } else {
       // create a new one
@@ -2358,6 +2576,7 @@ class SegmentSet {
       if (sid.raw() == 0) break;
       Segment::Ref(sid, "SegmentSet::FindExistingOrAlocateAndCopy");
       res_ss->SetSID(i, sid);
+      res_ss->tids_[i] = Segment::Get(sid)->tid().raw();
     }
     DCHECK(res_ss == Get(res_ssid));
     map_->Insert(res_ss, res_ssid);
@@ -2522,6 +2741,11 @@ class SegmentSet {
   // sids_ contains up to kMaxSegmentSetSize SIDs.
   // Contains zeros at the end if size < kMaxSegmentSetSize.
   SID     sids_[kMaxSegmentSetSize];
+  // tids_[i] is the thread of sids_[i], so that the same-thread checks in
+  // AddSegmentToTupleSS and RemoveSegmentFromTupleSS compare two small
+  // arrays instead of looking up every segment.
+  // Only valid in the SegmentSets stored in vec_.
+  int32_t tids_[kMaxSegmentSetSize];
   int32_t ref_count_;
 };
 
@@ -2648,12 +2872,18 @@ SSID SegmentSet::RemoveSegmentFromTupleSS(SSID ssid, SID sid_to_remove) {
   SID * tmp_sids = tmp.sids_;
   CHECK(sizeof(int32_t) == sizeof(SID));
 
+  // Segments which are sid_to_remove or are from the same thread.
+  uint32_t same_thread = ss->MatchSID(sid_to_remove) |
+      ss->MatchTID(Segment::Get(sid_to_remove)->tid());
+
   for (int i = 0; i < kMaxSegmentSetSize; i++, old_size++) {
     SID sid = ss->GetSID(i);
     if (sid.raw() == 0) break;
     DCHECK(sid.valid());
     Segment::AssertLive(sid, __LINE__);
-    if (Segment::HappensBeforeOrSameThread(sid, sid_to_remove))
+    DCHECK(TID(ss->tids_[i]) == Segment::Get(sid)->tid());
+    if ((same_thread & (1U << i)) ||
+        Segment::HappensBefore(sid, sid_to_remove))
       continue;  // Skip this segment from the result.
     tmp_sids[new_size++] = sid;
   }
@@ -2680,6 +2910,13 @@ SSID SegmentSet::AddSegmentToTupleSS(SSID ssid, SID new_sid) {
   const Segment *new_seg = Segment::Get(new_sid);
   TID            new_tid = new_seg->tid();
 
+  if (ss->MatchSID(new_sid)) {
+    // we are trying to insert a sid which is already there.
+    // SS will not change.
+    return ssid;
+  }
+  uint32_t same_thread = ss->MatchTID(new_tid);
+
   int32_t old_size = 0, new_size = 0;
   SID tmp_sids[kMaxSegmentSetSize + 1];
   CHECK(sizeof(int32_t) == sizeof(SID));
@@ -2690,16 +2927,11 @@ SSID SegmentSet::AddSegmentToTupleSS(SSID ssid, SID new_sid) {
     if (sid.raw() == 0) break;
     DCHECK(sid.valid());
     Segment::AssertLive(sid, __LINE__);
-    const Segment *seg = Segment::Get(sid);
-    TID            tid = seg->tid();
+    TID tid(ss->tids_[i]);
+    DCHECK(tid == Segment::Get(sid)->tid());
 
-    if (sid == new_sid) {
-      // we are trying to insert a sid which is already there.
-      // SS will not change.
-      return ssid;
-    }
-
-    if (tid == new_tid) {
+    if (same_thread & (1U << i)) {
+      const Segment *seg = Segment::Get(sid);
       if (seg->vts() == new_seg->vts() &&
           seg->lsid(true) == new_seg->lsid(true) &&
           seg->lsid(false) == new_seg->lsid(false)) {
@@ -2993,6 +3225,20 @@ INLINE bool GranularityIs1(uintptr_t off, uint16_t gr) {
   return ((gr >> (7 + off_within_8_bytes)) & 1);
 }
 
+// Returns a mask of 8 bits, one per byte of the 8 bytes described by 'gr'.
+// A bit is set if a shadow value may start at that byte.
+INLINE uint32_t GranularityStarts(uint16_t gr) {
+  uint32_t res = (gr >> 7) & 0xff;
+  if (gr & 1) res |= 1;
+  if (gr & (1 << 1)) res |= 1 << 0;
+  if (gr & (1 << 2)) res |= 1 << 4;
+  if (gr & (1 << 3)) res |= 1 << 0;
+  if (gr & (1 << 4)) res |= 1 << 2;
+  if (gr & (1 << 5)) res |= 1 << 4;
+  if (gr & (1 << 6)) res |= 1 << 6;
+  return res;
+}
+
 class CacheLine {
  public:
   static const uintptr_t kLineSizeBits = Mask::kNBitsLog;  // Don't change this.
@@ -3103,6 +3349,59 @@ class CacheLine {
     return &granularity_[off / 8];
   }
 
+  // Split the granules of bytes [from, to) of one 8-byte chunk down to
+  // granularity 'size' (4, 2 or 1). Same as calling Split_8_to_4,
+  // Split_4_to_2 and Split_2_to_1 for every byte in [from, to), but the new
+  // granularity mask is computed first and then all new shadow values are
+  // filled in one pass over the 8 bytes.
+  void SplitRange(uintptr_t from, uintptr_t to, uintptr_t size) {
+    DebugTrace(from, __FUNCTION__, __LINE__);
+    DCHECK(from < to);
+    DCHECK((from & ~7) == ((to - 1) & ~7));
+    DCHECK(size == 1 || size == 2 || size == 4);
+    uint16_t *granularity_mask_p = granularity_mask(from);
+    uint16_t old_gr = *granularity_mask_p;
+    uint16_t gr = old_gr;
+    uintptr_t from8 = from & 7, to8 = ((to - 1) & 7) + 1;
+    if (gr & 1) {
+      gr = 3 << 1;
+    }
+    if (size <= 2) {
+      for (uintptr_t i = from8 >> 2; i <= (to8 - 1) >> 2; i++) {
+        if (gr & (1 << (1 + i))) {
+          gr &= ~(1 << (1 + i));
+          gr |= 3 << (3 + 2 * i);
+        }
+      }
+    }
+    if (size == 1) {
+      for (uintptr_t i = from8 >> 1; i <= (to8 - 1) >> 1; i++) {
+        if (gr & (1 << (3 + i))) {
+          gr &= ~(1 << (3 + i));
+          gr |= 3 << (7 + 2 * i);
+        }
+      }
+    }
+    if (gr == old_gr) return;
+    uint32_t old_starts = GranularityStarts(old_gr);
+    uint32_t new_starts = GranularityStarts(gr) & ~old_starts;
+    // Copy the old shadow value of each granule to the new granules
+    // it was split into.
+    uintptr_t off8 = from & ~7;
+    uintptr_t src = off8;
+    for (uintptr_t i = 0; i < 8; i++) {
+      if (old_starts & (1 << i)) {
+        src = off8 + i;
+      } else if ((new_starts & (1 << i)) && has_shadow_value_.Get(src)) {
+        ShadowValue sval = GetValue(src);
+        sval.Ref("SplitRange");
+        *AddNewSvalAtOffset(off8 + i) = sval;
+      }
+    }
+    *granularity_mask_p = gr;
+    DebugTrace(from, __FUNCTION__, __LINE__);
+  }
+
   void Split_8_to_4(uintptr_t off) {
     DebugTrace(off, __FUNCTION__, __LINE__);
     uint16_t gr = *granularity_mask(off);
@@ -3289,11 +3588,20 @@ uintptr_t GetCacheLinesForRange(uintptr_t a, uintptr_t b,
 class Cache {
  public:
   Cache() {
-    memset(lines_, 0, sizeof(lines_));
+    // lines_ is already zeroed by operator new.
     ANNOTATE_BENIGN_RACE_SIZED(lines_, sizeof(lines_),
                                "Cache::lines_ accessed without a lock");
   }
 
+  // The cache is large: allocate it from a zeroed table and skip
+  // the memset in the constructor.
+  void *operator new(size_t size) {
+    return AllocateZeroedTable(size);
+  }
+  void operator delete(void *p) {
+    CHECK(0);
+  }
+
   INLINE static CacheLine *kLineIsLocked() {
     return (CacheLine*)1;
   }
@@ -3633,52 +3941,90 @@ static  Cache *G_cache;
 
 // -------- Published range -------------------- {{{1
 struct PublishInfo {
-  uintptr_t tag;   // Tag of the cache line where the mem is published.
   Mask      mask;  // The bits that are actually published.
   VTS      *vts;   // The point where this range has been published.
 };
 
+// All ranges published in one cache line. Almost always there is just one
+// publisher per line; it is kept inline, the others go to 'more'.
+struct PublishedLine {
+  PublishInfo  first;
+  vector<PublishInfo> *more;
 
-typedef multimap<uintptr_t, PublishInfo> PublishInfoMap;
+  size_t size() const { return 1 + (more ? more->size() : 0); }
+  PublishInfo &at(size_t i) { return i == 0 ? first : (*more)[i - 1]; }
+  void Remove(size_t i) {
+    DCHECK(more && !more->empty());
+    at(i) = more->back();
+    more->pop_back();
+  }
+};
 
-// Maps 'mem+size' to the PublishInfoMap{mem, size, vts}.
+typedef unordered_map<uintptr_t, PublishedLine> PublishInfoMap;
+
+// Maps the tag of a cache line to the ranges published in that line.
 static PublishInfoMap *g_publish_info_map;
+// Number of elements in g_publish_info_map. Read without a lock.
+static volatile size_t g_n_published_lines;
+// The number of lines in g_publish_info_map whose tag falls into each slot.
+// Read without a lock to skip the lines which are certainly not published.
+static const size_t kPublishedLineFilterSize = 1 << 12;
+static volatile int32_t g_published_line_filter[kPublishedLineFilterSize];
+
+static INLINE volatile int32_t *PublishedLineFilterSlot(uintptr_t tag) {
+  return &g_published_line_filter[(tag / CacheLine::kLineSize) %
+                                  kPublishedLineFilterSize];
+}
+
+// False if the line of 'a' is not published. Racey, but ok
+// (same as g_n_published_lines).
+static INLINE bool LineMayBePublished(uintptr_t a) {
+  return *PublishedLineFilterSlot(CacheLine::ComputeTag(a)) != 0;
+}
 
 const int kDebugPublish = 0;
 
 // Get a VTS where 'a' has been published,
 // return NULL if 'a' was not published.
-static const VTS *GetPublisherVTS(uintptr_t a) {
+static const VTS *FindPublisherVTS(uintptr_t a) {
   uintptr_t tag = CacheLine::ComputeTag(a);
   uintptr_t off = CacheLine::ComputeOffset(a);
-  typedef PublishInfoMap::iterator Iter;
-
-  pair<Iter, Iter> eq_range = g_publish_info_map->equal_range(tag);
-  for (Iter it = eq_range.first; it != eq_range.second; ++it) {
-    PublishInfo &info = it->second;
-    DCHECK(info.tag == tag);
-    if (info.mask.Get(off)) {
-      G_stats->publish_get++;
-      // Printf("GetPublisherVTS: a=%p vts=%p\n", a, info.vts);
-      return info.vts;
+  PublishInfoMap::iterator it = g_publish_info_map->find(tag);
+  if (it != g_publish_info_map->end()) {
+    PublishedLine &pl = it->second;
+    for (size_t i = 0; i < pl.size(); i++) {
+      PublishInfo &info = pl.at(i);
+      if (info.mask.Get(off)) {
+        G_stats->publish_get++;
+        // Printf("GetPublisherVTS: a=%p vts=%p\n", a, info.vts);
+        return info.vts;
+      }
     }
   }
-  Printf("GetPublisherVTS returned NULL: a=%p\n", a);
   return NULL;
 }
 
+// Same as FindPublisherVTS, but 'a' is expected to be published.
+static const VTS *GetPublisherVTS(uintptr_t a) {
+  const VTS *res = FindPublisherVTS(a);
+  if (!res)
+    Printf("GetPublisherVTS returned NULL: a=%p\n", a);
+  return res;
+}
+
 static bool CheckSanityOfPublishedMemory(uintptr_t tag, int line) {
   if (!TSAN_DEBUG) return true;
   if (kDebugPublish)
     Printf("CheckSanityOfPublishedMemory: line=%d\n", line);
-  typedef PublishInfoMap::iterator Iter;
-  pair<Iter, Iter> eq_range = g_publish_info_map->equal_range(tag);
+  CHECK(g_n_published_lines == g_publish_info_map->size());
+  PublishInfoMap::iterator it = g_publish_info_map->find(tag);
+  if (it == g_publish_info_map->end()) return true;
+  CHECK(*PublishedLineFilterSlot(tag) > 0);
+  PublishedLine &pl = it->second;
   Mask union_of_masks(0);
   // iterate over all entries for this tag
-  for (Iter it = eq_range.first; it != eq_range.second; ++it) {
-    PublishInfo &info = it->second;
-    CHECK(info.tag  == tag);
-    CHECK(it->first == tag);
+  for (size_t i = 0; i < pl.size(); i++) {
+    PublishInfo &info = pl.at(i);
     CHECK(info.vts);
     Mask mask(info.mask);
     CHECK(!mask.Empty());  // Mask should not be empty..
@@ -3689,35 +4035,48 @@ static bool CheckSanityOfPublishedMemory(uintptr_t tag, int line) {
   return true;
 }
 
+static void ClearPublishInfoMap() {
+  for (PublishInfoMap::iterator it = g_publish_info_map->begin();
+       it != g_publish_info_map->end(); ++it) {
+    delete it->second.more;
+  }
+  g_publish_info_map->clear();
+  g_n_published_lines = 0;
+  memset((void*)g_published_line_filter, 0, sizeof(g_published_line_filter));
+}
+
 // Clear the publish attribute for the bytes from 'line' that are set in 'mask'
 static void ClearPublishedAttribute(CacheLine *line, Mask mask) {
   CHECK(CheckSanityOfPublishedMemory(line->tag(), __LINE__));
-  typedef PublishInfoMap::iterator Iter;
-  bool deleted_some = true;
   if (kDebugPublish)
     Printf(" ClearPublishedAttribute: %p %s\n",
            line->tag(), mask.ToString().c_str());
-  while (deleted_some) {
-    deleted_some = false;
-    pair<Iter, Iter> eq_range = g_publish_info_map->equal_range(line->tag());
-    for (Iter it = eq_range.first; it != eq_range.second; ++it) {
-      PublishInfo &info = it->second;
-      DCHECK(info.tag == line->tag());
-      if (kDebugPublish)
-        Printf("?ClearPublishedAttribute: %p %s\n", line->tag(),
-               info.mask.ToString().c_str());
-      info.mask.Subtract(mask);
-      if (kDebugPublish)
-        Printf("+ClearPublishedAttribute: %p %s\n", line->tag(),
-               info.mask.ToString().c_str());
-      G_stats->publish_clear++;
-      if (info.mask.Empty()) {
-        VTS::Unref(info.vts);
-        g_publish_info_map->erase(it);
-        deleted_some = true;
-        break;
-      }
+  PublishInfoMap::iterator it = g_publish_info_map->find(line->tag());
+  if (it == g_publish_info_map->end()) return;
+  PublishedLine &pl = it->second;
+  for (size_t i = 0; i < pl.size(); ) {
+    PublishInfo &info = pl.at(i);
+    if (kDebugPublish)
+      Printf("?ClearPublishedAttribute: %p %s\n", line->tag(),
+             info.mask.ToString().c_str());
+    info.mask.Subtract(mask);
+    if (kDebugPublish)
+      Printf("+ClearPublishedAttribute: %p %s\n", line->tag(),
+             info.mask.ToString().c_str());
+    G_stats->publish_clear++;
+    if (!info.mask.Empty()) {
+      i++;
+      continue;
+    }
+    VTS::Unref(info.vts);
+    if (pl.size() == 1) {
+      delete pl.more;
+      g_publish_info_map->erase(it);
+      g_n_published_lines = g_publish_info_map->size();
+      (*PublishedLineFilterSlot(line->tag()))--;
+      break;
     }
+    pl.Remove(i);
   }
   CHECK(CheckSanityOfPublishedMemory(line->tag(), __LINE__));
 }
@@ -3743,10 +4102,21 @@ static void PublishRangeInOneLine(TSanThread *thr, uintptr_t addr, uintptr_t a,
   G_cache->ReleaseLine(thr, tag, line, __LINE__);
 
   PublishInfo pub_info;
-  pub_info.tag  = tag;
   pub_info.mask.SetRange(a, b);
   pub_info.vts  = vts->Clone();
-  g_publish_info_map->insert(make_pair(tag, pub_info));
+  PublishInfoMap::iterator it = g_publish_info_map->find(tag);
+  if (it == g_publish_info_map->end()) {
+    PublishedLine &pl = (*g_publish_info_map)[tag];
+    pl.first = pub_info;
+    pl.more = NULL;
+    g_n_published_lines = g_publish_info_map->size();
+    (*PublishedLineFilterSlot(tag))++;
+  } else {
+    PublishedLine &pl = it->second;
+    if (!pl.more)
+      pl.more = new vector<PublishInfo>;
+    pl.more->push_back(pub_info);
+  }
   G_stats->publish_set++;
   if (kDebugPublish)
     Printf("PublishRange   : [%p,%p) %p %s vts=%p\n",
@@ -3961,6 +4331,13 @@ struct LockHistory {
 // VTS changes or we do ForgetAllState.
 // TODO(timurrrr): probably we can cache segments with different LSes and
 // compare their LS with the current LS.
+//
+// With --keep_history=2 each cached segment also remembers the hash of
+// the call stack it was filled with (see TSanThread::StackHash()), so that
+// the usual match is a single compare instead of a stack walk. A hash
+// miss still falls back to the comparison of the three top frames: the
+// whole-stack hash is stricter and alone would create more segments.
+// A hash of 0 means "unknown"; such entries are never matched by hash.
 struct RecentSegmentsCache {
  public:
   RecentSegmentsCache(int cache_size) : cache_size_(cache_size) {}
@@ -3970,8 +4347,8 @@ struct RecentSegmentsCache {
     ShortenQueue(0);
   }
 
-  void Push(SID sid) {
-    queue_.push_front(sid);
+  void Push(SID sid, uintptr_t stack_hash = 0) {
+    queue_.push_front(Entry(sid, stack_hash));
     Segment::Ref(sid, "RecentSegmentsCache::ShortenQueue");
     ShortenQueue(cache_size_);
   }
@@ -3980,14 +4357,16 @@ struct RecentSegmentsCache {
     queue_.clear();  // Don't unref - the segments are already dead.
   }
 
-  INLINE SID Search(CallStack *curr_stack,
+  // If 'curr_stack_hash' is not 0, the segments are first matched by
+  // the hash of the whole call stack.
+  INLINE SID Search(CallStack *curr_stack, uintptr_t curr_stack_hash,
                     SID curr_sid, /*OUT*/ bool *needs_refill) {
     // TODO(timurrrr): we can probably move the matched segment to the head
     // of the queue.
 
-    deque<SID>::iterator it = queue_.begin();
+    deque<Entry>::iterator it = queue_.begin();
     for (; it != queue_.end(); it++) {
-      SID sid = *it;
+      SID sid = it->sid;
       Segment::AssertLive(sid, __LINE__);
       Segment *seg = Segment::Get(sid);
 
@@ -3998,6 +4377,12 @@ struct RecentSegmentsCache {
         // *) 1 if it is stored only in the cache,
         // *) 2 if it is the current segment of the Thread.
         *needs_refill = true;
+        it->stack_hash = curr_stack_hash;
+        return sid;
+      }
+
+      if (curr_stack_hash && it->stack_hash == curr_stack_hash) {
+        *needs_refill = false;
         return sid;
       }
 
@@ -4023,15 +4408,21 @@ struct RecentSegmentsCache {
   }
 
  private:
+  struct Entry {
+    Entry(SID s, uintptr_t h) : sid(s), stack_hash(h) {}
+    SID sid;
+    uintptr_t stack_hash;
+  };
+
   void ShortenQueue(size_t flush_to_length) {
     while (queue_.size() > flush_to_length) {
-      SID sid = queue_.back();
+      SID sid = queue_.back().sid;
       Segment::Unref(sid, "RecentSegmentsCache::ShortenQueue");
       queue_.pop_back();
     }
   }
 
-  deque<SID> queue_;
+  deque<Entry> queue_;
   size_t cache_size_;
 };
 
@@ -4258,6 +4649,7 @@ struct TSanThread {
       wr_lockset_(0),
       expensive_bits_(0),
       vts_at_exit_(NULL),
+      joined_(false),
       call_stack_(call_stack),
       lock_history_(128),
       recent_segments_cache_(G_flags->recent_segments_cache_size),
@@ -4286,6 +4678,23 @@ struct TSanThread {
     ComputeExpensiveBits();
   }
 
+  ~TSanThread() {
+    CHECK(!is_running_);
+    if (sid_.valid()) {
+      Segment::Unref(sid_, "TSanThread::~TSanThread");
+    }
+    VTS::Unref(vts_at_exit_);
+    StackTrace::Delete(creation_context_);
+    StackTrace::Delete(ignore_context_[0]);
+    StackTrace::Delete(ignore_context_[1]);
+    for (map<TID, ThreadCreateInfo>::iterator i =
+             child_tid_to_create_info_.begin();
+         i != child_tid_to_create_info_.end(); ++i) {
+      StackTrace::Delete(i->second.ctx);
+      VTS::Unref(i->second.vts);
+    }
+  }
+
   TID tid() const { return tid_; }
   TID parent_tid() const { return parent_tid_; }
 
@@ -4364,6 +4773,7 @@ struct TSanThread {
   }
 
   bool is_running() const { return is_running_; }
+  bool joined() const { return joined_; }
 
   INLINE void ComputeExpensiveBits() {
     bool has_expensive_flags = G_flags->trace_level > 0 ||
@@ -4425,6 +4835,8 @@ struct TSanThread {
     CHECK(vts_at_exit_);
     FlushDeadSids();
     ReleaseFreshSids();
+    // Let the recent segments die, so that the tid can be reused.
+    recent_segments_cache_.Clear();
     delete call_stack_;
     call_stack_ = NULL;
   }
@@ -4436,10 +4848,12 @@ struct TSanThread {
     TSanThread* joined_thread  = TSanThread::Get(joined_tid);
     // Sometimes the joined thread is not truly dead yet.
     // In that case we just take the current vts.
-    if (joined_thread->is_running_)
+    if (joined_thread->is_running_) {
       *vts_at_exit = joined_thread->vts()->Clone();
-    else
+    } else {
       *vts_at_exit = joined_thread->vts_at_exit_;
+      joined_thread->joined_ = true;
+    }
 
     if (*vts_at_exit == NULL) {
       Printf("vts_at_exit==NULL; parent=%d, child=%d\n",
@@ -4467,6 +4881,56 @@ struct TSanThread {
     return all_threads_[tid.raw()];
   }
 
+  // The tid of a joined thread may be given to a new thread
+  // (see --reuse_tids) once no segment of the old thread is alive except
+  // its final one, which only the old thread itself refers to.
+  // After that no report can mention the old thread, so its creation
+  // context and the rest of its metadata may go.
+  // VTSs may still have entries for the tid: the new thread continues
+  // the clock of the old one, so these entries keep their meaning.
+  static bool TidIsReusable(TID tid) {
+    TSanThread *old = GetIfExists(tid);
+    if (!old) return true;
+    if (old->is_running_ || !old->joined_) return false;
+    int32_t n_own_segments = 0;
+    if (old->sid_.valid()) {
+      if (Segment::Get(old->sid_)->ref_count() != 1) return false;
+      n_own_segments = 1;
+    }
+    return Segment::NumberOfLiveSegments(tid) == n_own_segments;
+  }
+
+  // A new thread reuses the tid of an old one. Delete the old thread
+  // and return its VTS at exit, or NULL if the tid is fresh.
+  // The frontend reuses a tid only for a thread created by the joiner
+  // after the join and checks TidIsReusable() first.
+  // *joined is false if the frontend reused the tid before the join
+  // has been seen: then there is no happens-before with the old thread.
+  static VTS *ReleaseTidForReuse(TID tid, bool *joined) {
+    *joined = true;
+    TSanThread *old = GetIfExists(tid);
+    if (!old) return NULL;
+    if (old->joined_ && !TidIsReusable(tid)) {
+      Report("WARNING: T%d is reused while its segments are alive; "
+             "reports on them will show the new thread\n", tid.raw());
+    }
+    VTS *res;
+    if (old->joined_) {
+      res = old->vts_at_exit_->Clone();
+    } else {
+      Report("WARNING: T%d has been reused before it was joined\n",
+             tid.raw());
+      *joined = false;
+      if (old->is_running_)
+        old->HandleThreadEnd();
+      res = old->vts_at_exit_->Clone();
+    }
+    delete old;
+    all_threads_[tid.raw()] = NULL;
+    G_stats->n_tids_reused++;
+    return res;
+  }
+
   void HandleAccessSet() {
     BitSet *rd_set = lock_era_access_set(false);
     BitSet *wr_set = lock_era_access_set(true);
@@ -4630,6 +5094,11 @@ struct TSanThread {
       VTS::Unref(it->second.vts);
       signaller_map_->erase(it);
     }
+    LightSyncMap::iterator light_it = light_sync_map_->find(cv);
+    if (light_it != light_sync_map_->end()) {
+      VTS::Unref(light_it->second.vts);
+      light_sync_map_->erase(light_it);
+    }
   }
 
   LSID lsid(bool is_w) {
@@ -4678,6 +5147,76 @@ struct TSanThread {
     }
   }
 
+  // Semaphores and spin locks.
+  // These are synchronized through LightSync objects instead of the
+  // SignallerMap. A release does not join the VTSs if one of them already
+  // happens-before the other. In the common case (the object is released by
+  // the thread which has acquired it last) the object's VTS is simply
+  // replaced by a reference to the releasing thread's VTS.
+  void HandleLightRelease(uintptr_t obj) {
+    LightSync *sync = &(*light_sync_map_)[obj];
+    VTS *cur_vts = vts();
+    if (!sync->vts) {
+      sync->vts = cur_vts->Clone();
+      G_stats->light_sync_release_clone++;
+    } else if (sync->vts == cur_vts ||
+               VTS::HappensBeforeCached(cur_vts, sync->vts)) {
+      // The object already knows everything we know.
+      G_stats->light_sync_release_noop++;
+    } else if (VTS::HappensBeforeCached(sync->vts, cur_vts)) {
+      VTS::Unref(sync->vts);
+      sync->vts = cur_vts->Clone();
+      G_stats->light_sync_release_clone++;
+    } else {
+      VTS *new_vts = VTS::Join(sync->vts, cur_vts);
+      VTS::Unref(sync->vts);
+      sync->vts = new_vts;
+      G_stats->light_sync_release_join++;
+    }
+    NewSegmentForSignal();
+    if (debug_happens_before) {
+      Printf("T%d: LightRelease: %p:\n    %s %s\n    %s\n", tid_.raw(), obj,
+             vts()->ToString().c_str(), Segment::ToString(sid()).c_str(),
+             (sync->vts)->ToString().c_str());
+    }
+  }
+
+  void HandleLightAcquire(uintptr_t obj) {
+    G_stats->light_sync_acquire++;
+    LightSyncMap::iterator it = light_sync_map_->find(obj);
+    if (it == light_sync_map_->end() || !it->second.vts) return;
+    const VTS *sync_vts = it->second.vts;
+    if (sync_vts == vts() || VTS::HappensBeforeCached(sync_vts, vts())) {
+      // Nothing new to learn, keep the current segment.
+      G_stats->light_sync_acquire_noop++;
+      return;
+    }
+    NewSegmentForWait(sync_vts);
+    if (debug_happens_before) {
+      Printf("T%d: LightAcquire: %p:\n    %s %s\n", tid_.raw(), obj,
+             vts()->ToString().c_str(), Segment::ToString(sid()).c_str());
+    }
+  }
+
+  // In pure happens-before mode a spin lock does not go to the lock sets,
+  // so it is handled as a light-weight sync object.
+  // In hybrid mode we need the lock sets, so fall back to HandleLock.
+  void HandleSpinLock(uintptr_t lock_addr) {
+    if (!G_flags->pure_happens_before) {
+      HandleLock(lock_addr, true);
+      return;
+    }
+    HandleLightAcquire(lock_addr);
+  }
+
+  void HandleSpinUnlock(uintptr_t lock_addr) {
+    if (!G_flags->pure_happens_before) {
+      HandleUnlock(lock_addr);
+      return;
+    }
+    HandleLightRelease(lock_addr);
+  }
+
   void INLINE NewSegmentWithoutUnrefingOld(const char *call_site,
                                            VTS *new_vts) {
     DCHECK(new_vts);
@@ -4732,7 +5271,7 @@ struct TSanThread {
     this->stats.history_creates_new_segment++;
     VTS *new_vts = vts()->Clone();
     NewSegment("HandleSblockEnter", new_vts);
-    recent_segments_cache_.Push(sid());
+    recent_segments_cache_.Push(sid(), StackHash());
     GetSomeFreshSids();  // fill the thread-local SID cache.
   }
 
@@ -4745,7 +5284,7 @@ struct TSanThread {
     SetTopPc(pc);
 
     bool refill_stack = false;
-    SID match = recent_segments_cache_.Search(call_stack_, sid(),
+    SID match = recent_segments_cache_.Search(call_stack_, StackHash(), sid(),
                                               /*OUT*/&refill_stack);
     DCHECK(kSizeOfHistoryStackTrace > 0);
 
@@ -4771,7 +5310,7 @@ struct TSanThread {
       this->AddDeadSid(sid_, "TSanThread::HandleSblockEnter-1");
       Segment::Ref(fresh_sid, "TSanThread::HandleSblockEnter-1");
       sid_ = fresh_sid;
-      recent_segments_cache_.Push(sid());
+      recent_segments_cache_.Push(sid(), StackHash());
       FillEmbeddedStackTrace(Segment::embedded_stack_trace(sid()));
       this->stats.history_uses_preallocated_segment++;
     } else {
@@ -4854,7 +5393,8 @@ struct TSanThread {
     }
   }
 
-  void HandleChildThreadStart(TID child_tid, VTS **vts, StackTrace **ctx) {
+  void HandleChildThreadStart(TID child_tid, int32_t child_clk,
+                              VTS **vts, StackTrace **ctx) {
     TSanThread *parent = this;
     ThreadCreateInfo info;
     if (child_tid_to_create_info_.count(child_tid)) {
@@ -4875,7 +5415,7 @@ struct TSanThread {
       parent->NewSegmentForSignal();
     }
     *ctx = info.ctx;
-    VTS *singleton = VTS::CreateSingleton(child_tid);
+    VTS *singleton = VTS::CreateSingleton(child_tid, child_clk);
     *vts = VTS::Join(singleton, info.vts);
     VTS::Unref(singleton);
     VTS::Unref(info.vts);
@@ -4981,6 +5521,14 @@ struct TSanThread {
     call_stack_->pop_back();
   }
 
+  // Hash of the call stack used by RecentSegmentsCache with
+  // --keep_history=2, or 0 if the hash is not available.
+  INLINE uintptr_t StackHash() {
+    if (G_flags->keep_history < 2 || !call_stack_->hash_is_valid())
+      return 0;
+    return call_stack_->hash();
+  }
+
   void HandleRtnCall(uintptr_t call_pc, uintptr_t target_pc,
                      IGNORE_BELOW_RTN ignore_below) {
     this->stats.events[RTN_CALL]++;
@@ -5103,7 +5651,7 @@ struct TSanThread {
       TSanThread *thr = Get(TID(i));
       thr->recent_segments_cache_.ForgetAllState();
       thr->sid_ = SID();  // Reset the old SID so we don't try to read its VTS.
-      VTS *singleton_vts = VTS::CreateSingleton(TID(i), 2);
+      VTS *singleton_vts = VTS::CreateSingletonAfterFlush(TID(i), 2);
       if (thr->is_running()) {
         thr->NewSegmentWithoutUnrefingOld("ForgetAllState", singleton_vts);
       }
@@ -5123,6 +5671,7 @@ struct TSanThread {
       thr->fresh_sids_.clear();
     }
     signaller_map_->ClearAndDeleteElements();
+    light_sync_map_->ClearAndDeleteElements();
   }
 
   static void InitClassMembers() {
@@ -5131,6 +5680,7 @@ struct TSanThread {
     memset(all_threads_, 0, sizeof(TSanThread*) * G_flags->max_n_threads);
     n_threads_          = 0;
     signaller_map_      = new SignallerMap;
+    light_sync_map_     = new LightSyncMap;
   }
 
   BitSet *lock_era_access_set(int is_w) {
@@ -5223,6 +5773,7 @@ struct TSanThread {
   StackTrace *ignore_context_[2];
 
   VTS *vts_at_exit_;
+  bool joined_;
 
   CallStack *call_stack_;
 
@@ -5259,12 +5810,30 @@ struct TSanThread {
      }
   };
 
+  // A semaphore or a spin lock.
+  struct LightSync {
+    LightSync() : vts(NULL) {}
+    VTS *vts;
+  };
+
+  class LightSyncMap: public unordered_map<uintptr_t, LightSync> {
+    public:
+     void ClearAndDeleteElements() {
+       for (iterator it = begin(); it != end(); ++it) {
+         VTS::Unref(it->second.vts);
+       }
+       clear();
+     }
+  };
+
   // All threads. The main thread has tid 0.
   static TSanThread **all_threads_;
   static int      n_threads_;
 
   // signaller address -> VTS
   static SignallerMap *signaller_map_;
+  // semaphore or spin lock address -> LightSync
+  static LightSyncMap *light_sync_map_;
   static CyclicBarrierMap *cyclic_barrier_map_;
 };
 
@@ -5276,6 +5845,7 @@ INLINE static int32_t raw_tid(TSanThread *t) {
 TSanThread                    **TSanThread::all_threads_;
 int                         TSanThread::n_threads_;
 TSanThread::SignallerMap       *TSanThread::signaller_map_;
+TSanThread::LightSyncMap       *TSanThread::light_sync_map_;
 TSanThread::CyclicBarrierMap   *TSanThread::cyclic_barrier_map_;
 
 
@@ -5493,7 +6063,7 @@ static void ForgetAllStateAndStartOver(TSanThread *thr, const char *reason) {
 
   G_heap_map->Clear();
 
-  g_publish_info_map->clear();
+  ClearPublishInfoMap();
 
   for (PCQMap::iterator it = g_pcq_map->begin(); it != g_pcq_map->end(); ++it) {
     PCQ &pcq = it->second;
@@ -5527,12 +6097,70 @@ static INLINE void FlushStateIfOutOfSegments(TSanThread *thr) {
 }
 
 // -------- Expected Race ---------------------- {{{1
-typedef  HeapMap<ExpectedRace> ExpectedRacesMap;
+// A flat index of expected races: a vector of pointers sorted by 'ptr'.
+// InsertInfo keeps it sorted (tests mostly register the races in the order
+// of addresses, so it usually appends), and the lookups do not modify it.
+// The entries are allocated one by one, so a pointer returned by GetInfo
+// stays valid after later inserts. Like HeapMap, a new entry replaces an
+// old one with the same 'ptr' (in place).
+// Modified under ts_lock only.
+class ExpectedRacesMap {
+ public:
+  typedef vector<ExpectedRace*>::const_iterator iterator;
+
+  iterator begin() const { return races_.begin(); }
+  iterator end() const { return races_.end(); }
+  size_t size() const { return races_.size(); }
+
+  void InsertInfo(uintptr_t a, ExpectedRace info) {
+    CHECK(a != 0 && a != (uintptr_t)-1);
+    CHECK(info.ptr == a);
+    vector<ExpectedRace*>::iterator it =
+        lower_bound(races_.begin(), races_.end(), a, PtrLess());
+    if (it != races_.end() && (*it)->ptr == a) {
+      **it = info;
+      return;
+    }
+    races_.insert(it, new ExpectedRace(info));
+  }
+
+  ExpectedRace *GetInfo(uintptr_t a) const {
+    // Find the last race with ptr <= a.
+    iterator it = upper_bound(races_.begin(), races_.end(), a, PtrLess());
+    if (it == races_.begin()) return NULL;
+    --it;
+    if ((*it)->ptr + (*it)->size > a) {
+      return *it;
+    }
+    return NULL;
+  }
+
+  void Clear() {
+    for (size_t i = 0; i < races_.size(); i++)
+      delete races_[i];
+    races_.clear();
+  }
+
+ private:
+  struct PtrLess {
+    bool operator() (uintptr_t a, const ExpectedRace *r) const {
+      return a < r->ptr;
+    }
+    bool operator() (const ExpectedRace *r, uintptr_t a) const {
+      return r->ptr < a;
+    }
+  };
+
+  vector<ExpectedRace*> races_;
+};
+
 static ExpectedRacesMap *G_expected_races_map;
 static bool g_expecting_races;
 static int g_found_races_since_EXPECT_RACE_BEGIN;
 
 ExpectedRace* ThreadSanitizerFindExpectedRace(uintptr_t addr) {
+  // Called by the race verifier, which does not hold ts_lock.
+  TIL til(ts_lock, 11);
   return G_expected_races_map->GetInfo(addr);
 }
 
@@ -5648,6 +6276,13 @@ class ReportStorage {
     if (G_flags->generate_suppressions) {
       Report("INFO: generate_suppressions = true\n");
     }
+    ReadSuppressions();
+  }
+
+  // Reads the default and the user-supplied suppressions
+  // replacing those read before.
+  void ReadSuppressions() {
+    suppressions_.Clear();
     // Read default suppressions
     int n = suppressions_.ReadFromString(default_suppressions);
     if (n == -1) {
@@ -6321,6 +6956,25 @@ class Detector {
     for (size_t i = 0; i < n; i++) DCHECK(tleb[i] == 0);
   }
 
+  // A trace skipped by LiteRace sampling is not checked for races, but
+  // its accesses to published memory still synchronize with the publisher.
+  void HandleSkippedTrace(TSanThread *thr, size_t n, uintptr_t *tleb) {
+    if (g_n_published_lines == 0) return;  // Racey, but ok.
+    if (thr->ignore_reads() && thr->ignore_writes()) return;
+    // Take ts_lock only if some line of the trace may be published.
+    size_t i = 0;
+    while (i < n && (tleb[i] == 0 || !LineMayBePublished(tleb[i]))) i++;
+    if (i == n) return;
+    TIL til(ts_lock, 9);
+    for (; i < n; i++) {
+      uintptr_t addr = tleb[i];
+      if (addr == 0 || !LineMayBePublished(addr)) continue;
+      const VTS *signaller_vts = FindPublisherVTS(addr);
+      if (signaller_vts)
+        thr->NewSegmentForWait(signaller_vts);
+    }
+  }
+
   // Special case of a trace with just one mop and no sblock.
   void INLINE HandleMemoryAccess(TSanThread *thr, uintptr_t pc,
                                  uintptr_t addr, uintptr_t size,
@@ -6351,7 +7005,7 @@ class Detector {
     int this_flush_missing = 0;
     for (ExpectedRacesMap::iterator it = G_expected_races_map->begin();
          it != G_expected_races_map->end(); ++it) {
-      ExpectedRace race = it->second;
+      ExpectedRace race = **it;
       if (debug_expected_races) {
         Printf("Checking if expected race fired: %p\n", race.ptr);
       }
@@ -6360,7 +7014,7 @@ class Detector {
           (G_flags->nacl_untrusted == race.is_nacl_untrusted)) {
         ++this_flush_missing;
         Printf("Missing an expected race on %p: %s (annotated at %s)\n",
-               it->first,
+               race.ptr,
                race.description,
                PcToRtnNameAndFilePos(race.pc).c_str());
       }
@@ -6559,6 +7213,11 @@ class Detector {
       case SIGNAL      : thr->HandleSignal(e->a());  break;
       case WAIT        : thr->HandleWait(e->a());   break;
 
+      case SEM_POST    : thr->HandleLightRelease(e->a()); break;
+      case SEM_WAIT    : thr->HandleLightAcquire(e->a()); break;
+      case SPIN_LOCK   : thr->HandleSpinLock(e->a());     break;
+      case SPIN_UNLOCK : thr->HandleSpinUnlock(e->a());   break;
+
       case CYCLIC_BARRIER_INIT:
         thr->HandleBarrierInit(e->a(), e->info());
         break;
@@ -6734,11 +7393,15 @@ class Detector {
              tid.raw(), ptr, size, descr);
     }
     // Simply set all 'racey' bits in the shadow state of [ptr, ptr+size).
-    for (uintptr_t p = ptr; p < ptr + size; p++) {
+    // One cache line lookup per line, not per byte.
+    for (uintptr_t p = ptr; p < ptr + size; ) {
+      uintptr_t tag = CacheLine::ComputeTag(p);
+      uintptr_t line_end = min(tag + CacheLine::kLineSize, ptr + size);
       CacheLine *line = G_cache->GetLineOrCreateNew(thr, p, __LINE__);
       CHECK(line);
-      line->racey().Set(CacheLine::ComputeOffset(p));
+      line->racey().SetRange(CacheLine::ComputeOffset(p), line_end - tag);
       G_cache->ReleaseLine(thr, p, line, __LINE__);
+      p = line_end;
     }
   }
 
@@ -6778,7 +7441,7 @@ class Detector {
       int i = 0;
       for (ExpectedRacesMap::iterator it = G_expected_races_map->begin();
            it != G_expected_races_map->end(); ++it) {
-        ExpectedRace &x = it->second;
+        ExpectedRace &x = **it;
         Printf("  [%d] %p [0x%lx]\n", i, &x, x.ptr);
         i++;
       }
@@ -6912,42 +7575,78 @@ class Detector {
 
   // return true if the current pair of read/write segment sets
   // describes a race.
+  //
+  // The lock sets and their signatures are gathered for all segments first.
+  // Then all pairs are checked in two passes: a pass of signature compares
+  // over all pairs, which decides most of them, and a pass of exact lock set
+  // intersections for the pairs with overlapping signatures.
+  // Happens-before is checked only for write-read pairs with disjoint
+  // lock sets.
   bool NOINLINE CheckIfRace(SSID rd_ssid, SSID wr_ssid) {
     int wr_ss_size = SegmentSet::Size(wr_ssid);
     int rd_ss_size = SegmentSet::Size(rd_ssid);
 
     DCHECK(wr_ss_size >= 2 || (wr_ss_size >= 1 && rd_ss_size >= 1));
 
-    // check all write-write pairs
+    SID w_sid[kMaxSegmentSetSize], r_sid[kMaxSegmentSetSize];
+    LSID w_ls[kMaxSegmentSetSize], r_ls[kMaxSegmentSetSize];
+    uint64_t w_sig[kMaxSegmentSetSize], r_sig[kMaxSegmentSetSize];
+    for (int w = 0; w < wr_ss_size; w++) {
+      w_sid[w] = SegmentSet::GetSID(wr_ssid, w, __LINE__);
+      w_ls[w] = Segment::Get(w_sid[w])->lsid(true);
+      w_sig[w] = LockSet::Signature(w_ls[w]);
+    }
+    for (int r = 0; r < rd_ss_size; r++) {
+      r_sid[r] = SegmentSet::GetSID(rd_ssid, r, __LINE__);
+      r_ls[r] = Segment::Get(r_sid[r])->lsid(false);
+      r_sig[r] = LockSet::Signature(r_ls[r]);
+    }
+
+    // Pass 1: signatures.
+    // Write-write pairs with disjoint signatures are races.
+    bool ww_disjoint = false;
+    for (int w1 = 0; w1 < wr_ss_size; w1++)
+      for (int w2 = w1 + 1; w2 < wr_ss_size; w2++)
+        ww_disjoint |= (w_sig[w1] & w_sig[w2]) == 0;
+    if (ww_disjoint)
+      return true;
+    // Write-read pairs with disjoint signatures are races unless ordered
+    // by happens-before.
+    // Bit (w * kMaxSegmentSetSize + r).
+    bitset<kMaxSegmentSetSize * kMaxSegmentSetSize> wr_disjoint;
+    for (int w = 0; w < wr_ss_size; w++)
+      for (int r = 0; r < rd_ss_size; r++)
+        if ((w_sig[w] & r_sig[r]) == 0)
+          wr_disjoint.set(w * kMaxSegmentSetSize + r);
+    for (int w = 0; wr_disjoint.any() && w < wr_ss_size; w++) {
+      for (int r = 0; r < rd_ss_size; r++) {
+        if (!wr_disjoint.test(w * kMaxSegmentSetSize + r)) continue;
+        if (!Segment::HappensBeforeOrSameThread(w_sid[w], r_sid[r]))
+          return true;
+      }
+    }
+
+    // Pass 2: exact intersections for overlapping signatures.
     for (int w1 = 0; w1 < wr_ss_size; w1++) {
-      SID w1_sid = SegmentSet::GetSID(wr_ssid, w1, __LINE__);
-      Segment *w1_seg = Segment::Get(w1_sid);
-      LSID w1_ls = w1_seg->lsid(true);
       for (int w2 = w1 + 1; w2 < wr_ss_size; w2++) {
-        DCHECK(wr_ssid.IsTuple());
-        SegmentSet *ss = SegmentSet::Get(wr_ssid);
-        LSID w2_ls = Segment::Get(ss->GetSID(w2))->lsid(true);
-        if (LockSet::IntersectionIsEmpty(w1_ls, w2_ls)) {
+        if (LockSet::IntersectionIsEmpty(w_ls[w1], w_ls[w2])) {
           return true;
         } else {
           // May happen only if the locks in the intersection are hybrid locks.
-          DCHECK(LockSet::HasNonPhbLocks(w1_ls) &&
-                 LockSet::HasNonPhbLocks(w2_ls));
+          DCHECK(LockSet::HasNonPhbLocks(w_ls[w1]) &&
+                 LockSet::HasNonPhbLocks(w_ls[w2]));
         }
       }
-      // check all write-read pairs
       for (int r = 0; r < rd_ss_size; r++) {
-        SID r_sid = SegmentSet::GetSID(rd_ssid, r, __LINE__);
-        Segment *r_seg = Segment::Get(r_sid);
-        LSID r_ls = r_seg->lsid(false);
-        if (Segment::HappensBeforeOrSameThread(w1_sid, r_sid))
+        if (wr_disjoint.test(w1 * kMaxSegmentSetSize + r)) continue;
+        if (Segment::HappensBeforeOrSameThread(w_sid[w1], r_sid[r]))
           continue;
-        if (LockSet::IntersectionIsEmpty(w1_ls, r_ls)) {
+        if (LockSet::IntersectionIsEmpty(w_ls[w1], r_ls[r])) {
           return true;
         } else {
           // May happen only if the locks in the intersection are hybrid locks.
-          DCHECK(LockSet::HasNonPhbLocks(w1_ls) &&
-                 LockSet::HasNonPhbLocks(r_ls));
+          DCHECK(LockSet::HasNonPhbLocks(w_ls[w1]) &&
+                 LockSet::HasNonPhbLocks(r_ls[r]));
         }
       }
     }
@@ -7277,7 +7976,7 @@ class Detector {
       } else {
         if (fast_path_only) return false;
         if (has_expensive_flags) thr->stats.n_slow_access4++;
-        cache_line->Split_8_to_4(off);
+        cache_line->SplitRange(off, off + 4, 4);
         cache_line->Join_1_to_2(off);
         cache_line->Join_1_to_2(off + 2);
         cache_line->Join_2_to_4(off);
@@ -7294,8 +7993,7 @@ class Detector {
       } else {
         if (fast_path_only) return false;
         if (has_expensive_flags) thr->stats.n_slow_access2++;
-        cache_line->Split_8_to_4(off);
-        cache_line->Split_4_to_2(off);
+        cache_line->SplitRange(off, off + 2, 2);
         cache_line->Join_1_to_2(off);
         goto slow_path;
       }
@@ -7310,9 +8008,7 @@ class Detector {
       } else {
         if (fast_path_only) return false;
         if (has_expensive_flags) thr->stats.n_slow_access1++;
-        cache_line->Split_8_to_4(off);
-        cache_line->Split_4_to_2(off);
-        cache_line->Split_2_to_1(off);
+        cache_line->SplitRange(off, off + 1, 1);
         goto slow_path;
       }
     } else {
@@ -7324,17 +8020,19 @@ class Detector {
       // TODO(kcc): do we want to handle the next cache line as well?
       b = a + mop->size();
       uintptr_t max_x = min(b, CacheLine::ComputeNextTag(a));
-      for (uintptr_t x = a; x < max_x; x++) {
+      // Split the bytes of each 8-byte chunk at once.
+      for (uintptr_t x = a; x < max_x; ) {
+        uintptr_t next_x = min(max_x, (x & ~7) + 8);
         off = CacheLine::ComputeOffset(x);
         DCHECK(CacheLine::ComputeTag(x) == cache_line->tag());
         uint16_t *granularity_mask = cache_line->granularity_mask(off);
         if (!*granularity_mask) {
           *granularity_mask = 1;
         }
-        cache_line->DebugTrace(off, __FUNCTION__, __LINE__);
-        cache_line->Split_8_to_4(off);
-        cache_line->Split_4_to_2(off);
-        cache_line->Split_2_to_1(off);
+        cache_line->SplitRange(off, off + (next_x - x), 1);
+        x = next_x;
+      }
+      for (uintptr_t x = a; x < max_x; x++) {
         if (!HandleMemoryAccessHelper(is_w, cache_line, x, 1, pc, thr, false))
           return false;
       }
@@ -7709,19 +8407,27 @@ one_call:
     //         child_tid.raw(), parent_tid.raw(), pc, getpid());
     VTS *vts = NULL;
     StackTrace *creation_context = NULL;
+    bool prev_joined;
+    VTS *prev_vts_at_exit = TSanThread::ReleaseTidForReuse(child_tid,
+                                                           &prev_joined);
+    int32_t clk = prev_vts_at_exit ? prev_vts_at_exit->clk(child_tid) + 1 : 1;
     if (child_tid == TID(0)) {
       // main thread, we are done.
       vts = VTS::CreateSingleton(child_tid);
     } else if (!parent_tid.valid()) {
       TSanThread::StopIgnoringAccessesInT0BecauseNewThreadStarted();
       Report("INFO: creating thread T%d w/o a parent\n", child_tid.raw());
-      vts = VTS::CreateSingleton(child_tid);
+      vts = VTS::CreateSingleton(child_tid, clk);
     } else {
       TSanThread::StopIgnoringAccessesInT0BecauseNewThreadStarted();
       TSanThread *parent = TSanThread::Get(parent_tid);
       CHECK(parent);
-      parent->HandleChildThreadStart(child_tid, &vts, &creation_context);
+      parent->HandleChildThreadStart(child_tid, clk, &vts, &creation_context);
+      if (prev_vts_at_exit && prev_joined) {
+        CHECK(VTS::HappensBefore(prev_vts_at_exit, vts));
+      }
     }
+    VTS::Unref(prev_vts_at_exit);
 
     if (!call_stack) {
       call_stack = new CallStack();
@@ -7832,6 +8538,10 @@ one_call:
     CHECK(vts_at_exit);
     CHECK(parent_thr->sid().valid());
     Segment::AssertLive(parent_thr->sid(),  __LINE__);
+    if (!TSanThread::Get(child_tid)->is_running()) {
+      // The final clock of the child is known now.
+      VTS::RetireThread(child_tid, vts_at_exit->clk(child_tid));
+    }
     parent_thr->NewSegmentForWait(vts_at_exit);
     if (debug_thread) {
       Printf("T%d:  THR_JOIN_AFTER T%d  : %s\n", tid.raw(),
@@ -7839,6 +8549,36 @@ one_call:
     }
   }
 
+  // The thread that called fork() is the only thread of the child process.
+  // Everything the other threads did before fork() happens-before
+  // the child, so the child joins all of them. The rest of the state
+  // is inherited as is.
+  void HandleForkInChild(TID tid) {
+    TSanThread *thr = TSanThread::Get(tid);
+    for (int i = 0; i < TSanThread::NumberOfThreads(); i++) {
+      TSanThread *other = TSanThread::Get(TID(i));
+      if (!other || other == thr || other->joined()) continue;
+      if (other->is_running()) {
+        G_stats->Add(other->stats);
+        other->stats.Clear();
+        other->HandleThreadEnd();
+      }
+      if (i == 0) {
+        // T0 can not be joined, so its tid is never reused.
+        thr->NewSegmentForWait(other->vts());
+        continue;
+      }
+      VTS *vts_at_exit = NULL;
+      thr->HandleThreadJoinAfter(&vts_at_exit, TID(i));
+      VTS::RetireThread(TID(i), vts_at_exit->clk(TID(i)));
+      thr->NewSegmentForWait(vts_at_exit);
+    }
+    if (debug_thread) {
+      Printf("T%d:  FORK_CHILD : %s\n", tid.raw(),
+             thr->vts()->ToString().c_str());
+    }
+  }
+
  public:
   // TODO(kcc): merge this into Detector class. (?)
   ReportStorage reports_;
@@ -8059,6 +8799,11 @@ void ThreadSanitizerParseFlags(vector<string> *args) {
   } else {
     G_flags->input_type = "str";
   }
+  FindStringFlag("merge_input", args, &G_flags->merge_input);
+  FindStringFlag("merge_output", args, &G_flags->merge_output);
+  FindIntFlag("checkpoint_at", 0, args, &G_flags->checkpoint_at);
+  FindStringFlag("checkpoint_file", args, &G_flags->checkpoint_file);
+  FindStringFlag("resume_from", args, &G_flags->resume_from);
 #endif
 
   // Check verbosity first.
@@ -8157,6 +8902,8 @@ void ThreadSanitizerParseFlags(vector<string> *args) {
   FindIntFlag("sampling", 0, args, &G_flags->literace_sampling);
   CHECK(G_flags->literace_sampling < 32);
   CHECK(G_flags->literace_sampling >= 0);
+  FindIntFlag("func_sampling", 0, args, &G_flags->func_sampling);
+  CHECK(G_flags->func_sampling >= 0);
   FindBoolFlag("start_with_global_ignore_on", false, args,
                &G_flags->start_with_global_ignore_on);
 
@@ -8275,6 +9022,8 @@ void ThreadSanitizerParseFlags(vector<string> *args) {
 
   FindBoolFlag("enable_atomic", false, args, &G_flags->enable_atomic);
 
+  FindBoolFlag("reuse_tids", true, args, &G_flags->reuse_tids);
+
   if (!args->empty()) {
     ReportUnknownFlagAndExit(args->front());
   }
@@ -8298,6 +9047,10 @@ void ThreadSanitizerParseFlags(vector<string> *args) {
 
 // -------- ThreadSanitizer ------------------ {{{1
 
+// The ignore lists in precompiled form, built by SetupIgnore().
+static IgnoreMatchers *g_ignore_matchers;
+static IgnoreMatchers *g_white_matchers;
+
 // Setup the list of functions/images/files to ignore.
 static void SetupIgnore() {
   g_ignore_lists = new IgnoreLists;
@@ -8430,6 +9183,11 @@ static void SetupIgnore() {
     string str = ThreadSanitizerReadFileToString(file_name, true);
     ReadIgnoresFromString(str, g_white_lists);
   }
+
+  g_ignore_matchers = new IgnoreMatchers;
+  g_ignore_matchers->Init(*g_ignore_lists);
+  g_white_matchers = new IgnoreMatchers;
+  g_white_matchers->Init(*g_white_lists);
 }
 
 void ThreadSanitizerSetUnwindCallback(ThreadSanitizerUnwindCallback cb) {
@@ -8457,9 +9215,9 @@ bool ThreadSanitizerWantToInstrumentSblock(uintptr_t pc) {
   G_stats->pc_to_strings++;
   PcToStrings(pc, false, &img_name, &rtn_name, &file_name, &line_no);
 
-  if (g_white_lists->ignores.size() > 0) {
-    bool in_white_list = TripleVectorMatchKnown(g_white_lists->ignores, 
-                                                rtn_name, img_name, file_name);
+  if (!g_white_matchers->ignores.empty()) {
+    bool in_white_list = g_white_matchers->ignores.Match(rtn_name, img_name,
+                                                         file_name);
     if (in_white_list) {
       if (debug_ignore) {
         Report("INFO: Whitelisted rtn: %s\n", rtn_name.c_str());
@@ -8476,10 +9234,10 @@ bool ThreadSanitizerWantToInstrumentSblock(uintptr_t pc) {
     return false;
   }
 
-  bool ignore = TripleVectorMatchKnown(g_ignore_lists->ignores,
-                                       rtn_name, img_name, file_name) ||
-                TripleVectorMatchKnown(g_ignore_lists->ignores_r,
-                                       rtn_name, img_name, file_name);
+  bool ignore =
+      g_ignore_matchers->ignores.Match(rtn_name, img_name, file_name) ||
+      g_ignore_matchers->ignores_r.Match(rtn_name, img_name, file_name) ||
+      g_ignore_matchers->ignores_sync.Match(rtn_name, img_name, file_name);
   if (debug_ignore) {
     Printf("%s: pc=%p file_name=%s img_name=%s rtn_name=%s ret=%d\n",
            __FUNCTION__, pc, file_name.c_str(), img_name.c_str(),
@@ -8494,8 +9252,7 @@ bool ThreadSanitizerWantToCreateSegmentsOnSblockEntry(uintptr_t pc) {
   rtn_name = PcToRtnName(pc, false);
   if (G_flags->keep_history == 0)
     return false;
-  return !(TripleVectorMatchKnown(g_ignore_lists->ignores_hist,
-                                  rtn_name, "", ""));
+  return !g_ignore_matchers->ignores_hist.Match(rtn_name, "", "");
 }
 
 // Returns true if function at "pc" is marked as "fun_r" in the ignore file.
@@ -8515,8 +9272,7 @@ bool NOINLINE ThreadSanitizerIgnoreAccessesBelowFunction(uintptr_t pc) {
   }
 
   string rtn_name = PcToRtnName(pc, false);
-  bool ret =
-      TripleVectorMatchKnown(g_ignore_lists->ignores_r, rtn_name, "", "");
+  bool ret = g_ignore_matchers->ignores_r.Match(rtn_name, "", "");
 
   if (TSAN_DEBUG) {
     // Heavy test for NormalizeFunctionName: test on all possible inputs in
@@ -8533,6 +9289,11 @@ bool NOINLINE ThreadSanitizerIgnoreAccessesBelowFunction(uintptr_t pc) {
   return ((*cache)[pc] = ret);
 }
 
+bool ThreadSanitizerTidIsReusable(int32_t tid) {
+  TIL til(ts_lock, 10);
+  return TSanThread::TidIsReusable(TID(tid));
+}
+
 // We intercept a user function with this name
 // and answer the user query with a non-NULL string.
 extern "C" const char *ThreadSanitizerQuery(const char *query) {
@@ -8545,6 +9306,19 @@ extern "C" const char *ThreadSanitizerQuery(const char *query) {
       G_flags->pure_happens_before == false) {
     ret = "1";
   }
+  if (str == "reuse_tids" && G_flags->reuse_tids == true) {
+    ret = "1";
+  }
+  if (str == "n_tids_reused") {
+    static char buf[32];
+    snprintf(buf, sizeof(buf), "%ld", (long)G_stats->n_tids_reused);
+    ret = buf;
+  }
+  if (str == "n_reports") {
+    static char buf[32];
+    snprintf(buf, sizeof(buf), "%d", GetNumberOfFoundErrors());
+    ret = buf;
+  }
   if (str == "race_verifier" && g_race_verifier_active == true) {
     ret = "1";
   }
@@ -8635,6 +9409,10 @@ extern void ThreadSanitizerFini() {
   G_detector->HandleProgramEnd();
 }
 
+extern void ThreadSanitizerReloadSuppressions() {
+  G_detector->reports_.ReadSuppressions();
+}
+
 extern void ThreadSanitizerDumpAllStacks() {
   // first, print running threads.
   for (int i = 0; i < TSanThread::NumberOfThreads(); i++) {
@@ -8653,6 +9431,13 @@ extern void ThreadSanitizerDumpAllStacks() {
 }
 
 
+#ifdef TS_LLVM
+void ThreadSanitizerHandleForkInChild(int32_t tid) {
+  AssertTILHeld();
+  G_detector->HandleForkInChild(TID(tid));
+}
+#endif
+
 extern void ThreadSanitizerHandleOneEvent(Event *e) {
   // Lock is inside on some paths.
   G_detector->HandleOneEvent(e);
@@ -8677,6 +9462,19 @@ extern NOINLINE void ThreadSanitizerHandleTrace(TSanThread *thr, TraceInfo *trac
                           tleb, /*need_locking=*/true);
 }
 
+extern NOINLINE void ThreadSanitizerHandleSkippedTrace(int32_t tid,
+                                                       TraceInfo *trace_info,
+                                                       uintptr_t *tleb) {
+  ThreadSanitizerHandleSkippedTrace(TSanThread::Get(TID(tid)), trace_info,
+                                    tleb);
+}
+extern NOINLINE void ThreadSanitizerHandleSkippedTrace(TSanThread *thr,
+                                                       TraceInfo *trace_info,
+                                                       uintptr_t *tleb) {
+  DCHECK(thr);
+  G_detector->HandleSkippedTrace(thr, trace_info->n_mops(), tleb);
+}
+
 extern NOINLINE void ThreadSanitizerHandleOneMemoryAccess(TSanThread *thr,
                                                           MopInfo mop,
                                                           uintptr_t addr) {
@@ -47,7 +47,12 @@ string Demangle(const char *str);
 //--------- FLAGS ---------------------------------- {{{1
 struct FLAGS {
   string           input_type; // for ts_offline.
-                               // Possible values: str, bin, decode.
+                               // Possible values: str, bin, decode, merge.
+  vector<string>   merge_input;   // Per-thread event files to merge.
+  string           merge_output;  // Write the merged events here.
+  intptr_t         checkpoint_at;    // Event offset of the checkpoint.
+  string           checkpoint_file;  // Write the checkpoint here.
+  string           resume_from;      // Resume from this checkpoint.
   bool             ignore_stack;
   intptr_t         verbosity;
   intptr_t         show_stats;  // 0 -- no stats; 1 -- some stats; 2 more stats.
@@ -73,7 +78,7 @@ struct FLAGS {
 
   intptr_t         num_callers;
 
-  intptr_t    keep_history;
+  intptr_t    keep_history;  // 2 -- reuse segments by call stack hash.
   bool        pure_happens_before;
   bool        free_is_write;
   bool        exit_after_main;
@@ -103,6 +108,7 @@ struct FLAGS {
   intptr_t     flush_period;
 
   intptr_t     literace_sampling;
+  intptr_t     func_sampling;
   bool         start_with_global_ignore_on;
 
   intptr_t     locking_scheme;  // Used for internal experiments with locking.
@@ -137,6 +143,10 @@ struct FLAGS {
 
   bool enable_atomic;
 
+  bool reuse_tids;  // Let new threads reuse the tids of joined threads.
+                    // Off by default: reports on the segments of a joined
+                    // thread then show the context of the new thread.
+
   FLAGS() {
     // Force default verbosity to 0 as we have to carefully work around
     // different -q/--q/-v/--v flags when using Valgrind.
@@ -160,12 +170,76 @@ extern bool debug_race_verifier;
 
 // -------- CallStack ------------- {{{1
 const size_t kMaxCallStackSize = 1 << 12;
-
+// Only the bottom frames are hashed, so that the hashes do not double
+// the size of the (thread-local) shadow stack.
+const size_t kMaxHashedCallStackSize = 1 << 8;
+
+// The shadow stack also keeps a rolling hash of its frames, so that the
+// identity of the whole stack can be taken in O(1) (see CallStackHash()).
+// hashes_[i] is the hash of pcs_[0, i); the top pc is mixed in on demand
+// since it changes on every superblock. hashes_[0, hashed_end_ - pcs_) are
+// valid, they are maintained by CallStackPushHash/CallStackPopHash.
+// Code that moves end_ directly must keep hashed_end_ <= end_ (the inline
+// shadow stack updates of the LLVM instrumentation lower hashed_end_ on
+// function exit), otherwise frames rewritten below hashed_end_ would keep
+// their old hashes. Pushing without hashing leaves hashed_end_ behind end_,
+// which makes the hash unavailable until the stack unwinds back to
+// hashed_end_ or CallStackRehash() is called. So does a stack deeper than
+// kMaxHashedCallStackSize.
 struct CallStackPod {
   uintptr_t *end_;
   uintptr_t pcs_[kMaxCallStackSize];
+  // The fields below are only accessed by the instrumented code
+  // to lower hashed_end_ (see above).
+  uintptr_t *hashed_end_;
+  uintptr_t hashes_[kMaxHashedCallStackSize];
 };
 
+const uintptr_t kCallStackHashSeed = (uintptr_t)0x5bd1e9955bd1e995ULL;
+
+inline uintptr_t CallStackHashMix(uintptr_t hash, uintptr_t pc) {
+  hash = (hash ^ pc) * (uintptr_t)0x9E3779B97F4A7C15ULL;
+  return hash ^ (hash >> 29);
+}
+
+// Must be called right before pushing a new frame.
+inline void CallStackPushHash(CallStackPod *stack) {
+  if (stack->hashed_end_ != stack->end_) return;
+  size_t n = stack->end_ - stack->pcs_;
+  if (n == kMaxHashedCallStackSize) return;
+  stack->hashes_[n] = n == 0 ? kCallStackHashSeed :
+      CallStackHashMix(stack->hashes_[n - 1], stack->pcs_[n - 1]);
+  stack->hashed_end_++;
+}
+
+// Must be called right after popping a frame.
+inline void CallStackPopHash(CallStackPod *stack) {
+  if (stack->hashed_end_ == stack->end_ + 1)
+    stack->hashed_end_--;
+}
+
+// Recomputes all the hashes, O(stack size).
+inline void CallStackRehash(CallStackPod *stack) {
+  uintptr_t *end = stack->end_;
+  stack->hashed_end_ = stack->end_ = stack->pcs_;
+  while (stack->end_ != end) {
+    CallStackPushHash(stack);
+    stack->end_++;
+  }
+}
+
+inline bool CallStackHashIsValid(const CallStackPod *stack) {
+  return stack->hashed_end_ == stack->end_;
+}
+
+// Never returns 0.
+inline uintptr_t CallStackHash(const CallStackPod *stack) {
+  DCHECK(CallStackHashIsValid(stack));
+  size_t n = stack->end_ - stack->pcs_;
+  if (n == 0) return kCallStackHashSeed;
+  return CallStackHashMix(stack->hashes_[n - 1], stack->pcs_[n - 1]) | 1;
+}
+
 struct CallStack: public CallStackPod {
 
   CallStack() { Clear(); }
@@ -183,16 +257,19 @@ struct CallStack: public CallStackPod {
   void pop_back() {
     DCHECK(!empty());
     end_--;
+    CallStackPopHash(this);
   }
 
   void push_back(uintptr_t pc) {
     DCHECK(size() < kMaxCallStackSize);
+    CallStackPushHash(this);
     *end_ = pc;
     end_++;
   }
 
   void Clear() {
     end_ = pcs_;
+    hashed_end_ = pcs_;
   }
 
   uintptr_t &operator[] (size_t i) {
@@ -200,6 +277,8 @@ struct CallStack: public CallStackPod {
     return pcs_[i];
   }
 
+  bool hash_is_valid() const { return CallStackHashIsValid(this); }
+  uintptr_t hash() const { return CallStackHash(this); }
 };
 
 //--------- TS Exports ----------------- {{{1
@@ -209,10 +288,15 @@ struct CallStack: public CallStackPod {
 struct TSanThread;
 void ThreadSanitizerInit();
 void ThreadSanitizerFini();
+// Re-reads the suppression files listed in G_flags->suppressions.
+void ThreadSanitizerReloadSuppressions();
 // TODO(glider): this is a temporary solution to avoid deadlocks after fork().
 #ifdef TS_LLVM
 void ThreadSanitizerLockAcquire();
 void ThreadSanitizerLockRelease();
+// Called in the child process right after fork() by the thread that forked,
+// with the lock taken by ThreadSanitizerLockAcquire() still held.
+void ThreadSanitizerHandleForkInChild(int32_t tid);
 #endif
 void ThreadSanitizerHandleOneEvent(Event *event);
 TSanThread *ThreadSanitizerGetThreadByTid(int32_t tid);
@@ -220,6 +304,12 @@ void ThreadSanitizerHandleTrace(int32_t tid, TraceInfo *trace_info,
                                        uintptr_t *tleb);
 void ThreadSanitizerHandleTrace(TSanThread *thr, TraceInfo *trace_info,
                                        uintptr_t *tleb);
+// Called instead of ThreadSanitizerHandleTrace for a trace skipped
+// by sampling.
+void ThreadSanitizerHandleSkippedTrace(int32_t tid, TraceInfo *trace_info,
+                                       uintptr_t *tleb);
+void ThreadSanitizerHandleSkippedTrace(TSanThread *thr, TraceInfo *trace_info,
+                                       uintptr_t *tleb);
 void ThreadSanitizerHandleOneMemoryAccess(TSanThread *thr, MopInfo mop,
                                                  uintptr_t addr);
 void ThreadSanitizerParseFlags(vector<string>* args);
@@ -271,6 +361,8 @@ void ThreadSanitizerHandleRtnExit(int32_t tid);
 
 void ThreadSanitizerPrintUsage();
 extern "C" const char *ThreadSanitizerQuery(const char *query);
+// True if a new thread may get the tid of a joined thread (--reuse_tids).
+bool ThreadSanitizerTidIsReusable(int32_t tid);
 bool PhaseDebugIsOn(const char *phase_name);
 
 extern bool g_has_entered_main;
@@ -30,10 +30,16 @@
 // This file contains tests for various parts of ThreadSanitizer.
 
 #include <gtest/gtest.h>
+#ifndef _MSC_VER
+#include <pthread.h>
+#endif
 
 #include "ts_heap_info.h"
 #include "ts_simple_cache.h"
+#include "ts_retired_threads.h"
 #include "dense_multimap.h"
+#include "ignore.h"
+#include "thread_sanitizer.h"
 
 // Testing the HeapMap.
 struct TestHeapInfo {
@@ -207,6 +213,77 @@ TEST(ThreadSanitizer, IntPairToBoolCacheTest) {
   }
 }
 
+TEST(ThreadSanitizer, ConcurrentIntPairToBoolCacheTest) {
+  ConcurrentIntPairToBoolCache<4, 67> c;
+  bool val = false;
+  map<pair<int,int>, bool> m;
+
+  for (int i = 0; i < 1000000; i++) {
+    int a = (rand() % 1024) + 1;
+    int b = (rand() % 1024) + 1;
+
+    if (c.Lookup(a, b, &val)) {
+      EXPECT_EQ(1U, m.count(make_pair(a,b)));
+      EXPECT_EQ(val, m[make_pair(a,b)]);
+    }
+
+    val = (rand() % 2) == 1;
+    c.Insert(a, b, val);
+    m[make_pair(a,b)] = val;
+
+    if ((i % 100000) == 0) {
+      c.Flush();
+      m.clear();
+      EXPECT_FALSE(c.Lookup(a, b, &val));
+    }
+  }
+}
+
+#ifndef _MSC_VER
+// Several threads hammer one shard of a ConcurrentIntPairToBoolCache.
+// The value of a key is a function of the key, so a lookup which returns
+// a value for another key (e.g. from a torn entry) is caught.
+typedef ConcurrentIntPairToBoolCache<4, 67> ConcurrentTestCache;
+static ConcurrentTestCache *concurrent_test_cache;
+static volatile int concurrent_test_errors;
+
+static bool ConcurrentTestValue(uint32_t a, uint32_t b) {
+  return ((a * 7) ^ (b * 13)) & 4;
+}
+
+static void *ConcurrentCacheWorker(void *arg) {
+  unsigned seed = (uintptr_t)arg;
+  for (int i = 0; i < 1000000; i++) {
+    uint32_t a = (rand_r(&seed) % 512) + 1;
+    // All the keys go to shard 0.
+    uint32_t b = ((rand_r(&seed) % 512) + 1) * 4;
+    bool val;
+    if (concurrent_test_cache->Lookup(a, b, &val) &&
+        val != ConcurrentTestValue(a, b)) {
+      __sync_add_and_fetch(&concurrent_test_errors, 1);
+    }
+    concurrent_test_cache->Insert(a, b, ConcurrentTestValue(a, b));
+    if ((i % 100000) == 0)
+      concurrent_test_cache->Flush();
+  }
+  return NULL;
+}
+
+TEST(ThreadSanitizer, ConcurrentIntPairToBoolCacheThreadsTest) {
+  const int kNumThreads = 4;
+  concurrent_test_cache = new ConcurrentTestCache;
+  concurrent_test_errors = 0;
+  pthread_t threads[kNumThreads];
+  for (int i = 0; i < kNumThreads; i++)
+    pthread_create(&threads[i], NULL, ConcurrentCacheWorker,
+                   (void*)(uintptr_t)(i + 1));
+  for (int i = 0; i < kNumThreads; i++)
+    pthread_join(threads[i], NULL);
+  EXPECT_EQ(0, concurrent_test_errors);
+  delete concurrent_test_cache;
+}
+#endif  // _MSC_VER
+
 TEST(ThreadSanitizer, DenseMultimapTest) {
   typedef DenseMultimap<int, 3> Map;
 
@@ -254,6 +331,81 @@ TEST(ThreadSanitizer, DenseMultimapTest) {
   Map m9(m8, Map::REMOVE, 1);
   EXPECT_EQ(m9.size(), 5U);
   EXPECT_FALSE(m9.has(1));
+
+  Map m10(4, 6);
+  EXPECT_FALSE(m1.Intersects(m10));
+  EXPECT_TRUE(m2.Intersects(m1));
+  EXPECT_FALSE(m9.Intersects(m10));
+  EXPECT_TRUE(m9.Intersects(m2));
+  EXPECT_TRUE(m9.Intersects(m7));
+  Map m11(m9, Map::REMOVE, 2);
+  EXPECT_TRUE(m11.Intersects(m2));
+  EXPECT_FALSE(Map(m11, Map::REMOVE, 2).Intersects(m2));
+}
+
+TEST(ThreadSanitizer, CallStackHashTest) {
+  CallStack *s = new CallStack;
+  EXPECT_TRUE(s->hash_is_valid());
+  uintptr_t empty_hash = s->hash();
+
+  s->push_back(0x100);
+  s->push_back(0x200);
+  uintptr_t h1 = s->hash();
+  EXPECT_NE(h1, empty_hash);
+  s->back() = 0x210;  // The top pc is not cached.
+  EXPECT_NE(h1, s->hash());
+  s->back() = 0x200;
+  EXPECT_EQ(h1, s->hash());
+
+  s->push_back(0x300);
+  EXPECT_NE(h1, s->hash());
+  s->pop_back();
+  EXPECT_EQ(h1, s->hash());
+
+  // A different frame below the top gives a different hash.
+  s->pop_back();
+  s->back() = 0x110;
+  s->push_back(0x200);
+  EXPECT_NE(h1, s->hash());
+  s->pop_back();
+  s->pop_back();
+  EXPECT_EQ(empty_hash, s->hash());
+
+  // Moving end_ directly invalidates the hash until it is recomputed.
+  s->pcs_[0] = 0x100;
+  s->pcs_[1] = 0x200;
+  s->end_ += 2;
+  EXPECT_FALSE(s->hash_is_valid());
+  CallStackRehash(s);
+  EXPECT_TRUE(s->hash_is_valid());
+  EXPECT_EQ(h1, s->hash());
+
+  // Inline updates: pop two frames and push two others, lowering
+  // hashed_end_ as the instrumentation does. The stale hashes of the
+  // rewritten frames must not be used.
+  s->push_back(0x300);
+  uintptr_t h2 = s->hash();
+  s->end_ -= 2;
+  if (s->hashed_end_ > s->end_) s->hashed_end_ = s->end_;
+  s->pcs_[1] = 0x220;
+  s->pcs_[2] = 0x300;
+  s->end_ += 2;
+  EXPECT_FALSE(s->hash_is_valid());
+  CallStackRehash(s);
+  EXPECT_NE(h2, s->hash());
+  s->Clear();
+
+  // Frames above kMaxHashedCallStackSize are not hashed.
+  for (size_t i = 0; i < kMaxHashedCallStackSize; i++)
+    s->push_back(0x1000 + i);
+  EXPECT_TRUE(s->hash_is_valid());
+  uintptr_t h3 = s->hash();
+  s->push_back(0x100);
+  EXPECT_FALSE(s->hash_is_valid());
+  s->pop_back();
+  EXPECT_TRUE(s->hash_is_valid());
+  EXPECT_EQ(h3, s->hash());
+  delete s;
 }
 
 TEST(ThreadSanitizer, NormalizeFunctionNameNotChangingTest) {
@@ -393,6 +545,90 @@ TEST(ThreadSanitizer, NormalizeFunctionNameChangingTest) {
   }
 }
 
+TEST(ThreadSanitizer, IgnoreMatcherTest) {
+  IgnoreLists lists;
+  ReadIgnoresFromString(
+      "fun:foo\n"
+      "fun:foo_bar*\n"
+      "fun:*Lock*\n"
+      "fun:std::vector<*>::push_back\n"
+      "fun:a?c\n"
+      "fun:x**\n"
+      "src:*/third_party/*\n"
+      "obj:*libc.so*\n"
+      "fun_sync:*AtomicRefCount*\n",
+      &lists);
+  EXPECT_EQ(8U, lists.ignores.size());
+  EXPECT_EQ(1U, lists.ignores_sync.size());
+  IgnoreMatcher matcher(lists.ignores);
+  EXPECT_FALSE(matcher.empty());
+  EXPECT_TRUE(IgnoreMatcher().empty());
+
+  const char *funs[] = {
+    "", "foo", "fo", "foo1", "foo_bar", "foo_barbaz", "MutexLock",
+    "Lock", "std::vector<int>::push_back", "std::vector<int>::pop_back",
+    "abc", "abbc", "ac", "x", "xyz", "y",
+  };
+  const char *files[] = { "", "a.cc", "/src/third_party/b.cc" };
+  const char *objs[] = { "", "libc.so.6", "a.out" };
+  for (size_t f = 0; f < sizeof(funs) / sizeof(funs[0]); f++) {
+    for (size_t s = 0; s < sizeof(files) / sizeof(files[0]); s++) {
+      for (size_t o = 0; o < sizeof(objs) / sizeof(objs[0]); o++) {
+        EXPECT_EQ(TripleVectorMatchKnown(lists.ignores,
+                                         funs[f], objs[o], files[s]),
+                  matcher.Match(funs[f], objs[o], files[s]))
+            << funs[f] << " " << objs[o] << " " << files[s];
+      }
+    }
+  }
+
+  IgnoreMatchers matchers;
+  matchers.Init(lists);
+  EXPECT_TRUE(matchers.ignores_sync.MatchFunction(
+      "_ZN15AtomicRefCount3IncEv", "AtomicRefCount::Inc()", ""));
+  EXPECT_TRUE(matchers.ignores.MatchFunction("_Z3foov", "foo", ""));
+  EXPECT_FALSE(matchers.ignores.MatchFunction("_Z3foov", "", ""));
+  EXPECT_FALSE(matchers.ignores_r.MatchFunction("foo", "foo", "a.cc"));
+}
+
+// Testing the table of retired threads (dead thread compaction of VTS).
+TEST(ThreadSanitizer, RetiredThreadsTest) {
+  RetiredThreads retired(10, 2, 4);
+  EXPECT_EQ(0, retired.size());
+  EXPECT_TRUE(retired.Retire(1, 5));  // Generation 1.
+  EXPECT_TRUE(retired.Retire(2, 3));  // Generation 2.
+  EXPECT_TRUE(retired.Retire(1, 9));  // Generation 3, T1 reused.
+  EXPECT_EQ(3, retired.size());
+
+  EXPECT_EQ(2, retired.Get(2).tid);
+  EXPECT_EQ(3, retired.Get(2).clk);
+  EXPECT_EQ(1, retired.Get(3).prev_gen);
+
+  EXPECT_EQ(0, retired.ImplicitClk(1, 0));
+  EXPECT_EQ(5, retired.ImplicitClk(1, 1));
+  EXPECT_EQ(5, retired.ImplicitClk(1, 2));
+  EXPECT_EQ(9, retired.ImplicitClk(1, 3));
+  EXPECT_EQ(0, retired.ImplicitClk(2, 1));
+  EXPECT_EQ(3, retired.ImplicitClk(2, 3));
+  EXPECT_EQ(0, retired.ImplicitClk(3, 3));
+}
+
+TEST(ThreadSanitizer, RetiredThreadsFullTest) {
+  // 3 chunks of 2 entries.
+  RetiredThreads retired(10, 2, 3);
+  for (int i = 0; i < 6; i++) {
+    EXPECT_TRUE(retired.Retire(i, i + 1));
+  }
+  // The table is full: nothing is retired and nothing changes.
+  EXPECT_FALSE(retired.Retire(7, 1));
+  EXPECT_FALSE(retired.Retire(0, 10));
+  EXPECT_EQ(6, retired.size());
+  EXPECT_EQ(0, retired.ImplicitClk(7, 6));
+  EXPECT_EQ(1, retired.ImplicitClk(0, 6));
+  EXPECT_EQ(6, retired.ImplicitClk(5, 6));
+  EXPECT_EQ(0, retired.ImplicitClk(5, 5));
+}
+
 int main(int argc, char **argv) {
   testing::InitGoogleTest(&argc, argv);
   return RUN_ALL_TESTS();
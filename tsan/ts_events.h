@@ -93,6 +93,10 @@ enum EventType {
   PC_DESCRIPTION,     // {0, pc, descr_str, 0}, for ts_offline.
   PRINT_MESSAGE,      // {tid, pc, message_str, 0}, for ts_offline.
   FLUSH_EXPECTED_RACES,  // {0, 0, 0, 0}
+  SEM_POST,           // {tid, pc, sem, 0}
+  SEM_WAIT,           // {tid, pc, sem, 0}
+  SPIN_LOCK,          // {tid, pc, lock, 0}
+  SPIN_UNLOCK,        // {tid, pc, lock, 0}
   LAST_EVENT          // Should not appear.
 };
 
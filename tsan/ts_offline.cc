@@ -31,6 +31,13 @@
 // Experimental off-line race detector.
 // Reads program events from a file and detects races.
 // See http://code.google.com/p/data-race-test
+//
+// With --input_type=merge the events are read from several per-thread
+// files (--merge_input=file, repeated) in the str format. Events that
+// take part in synchronization are prefixed with a global sequence
+// number, e.g. '@1f UNLOCK 1 bb ff0 0'. The files are merged so that
+// these events come in the order of their sequence numbers, and other
+// events keep their order within the file.
 
 // ------------- Includes ------------- {{{1
 #include "thread_sanitizer.h"
@@ -40,6 +47,21 @@
 #include <stdarg.h>
 #include <ctype.h>
 #include <time.h>
+#ifdef __linux__
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/personality.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <functional>
+#include <queue>
+using std::greater;
+using std::pair;
+using std::priority_queue;
 
 // ------------- Globals ------------- {{{1
 static map<string, int> *g_event_type_map;
@@ -53,6 +75,210 @@ struct PcInfo {
 static map<uintptr_t, PcInfo> *g_pc_info_map;
 
 unsigned long offline_line_n;
+
+//------------- Arena ------------ {{{1
+// When checkpoints are used (--checkpoint_file or --resume_from), all
+// memory allocated with 'new' in ts_offline, and thus all of the detector
+// state, comes from one arena mapped at a fixed address. Together with the
+// static data of the binary it forms an image of the detector that can be
+// written to a checkpoint and read back (see "Checkpoints" below).
+// Otherwise 'new' uses malloc. The flags are looked up in
+// /proc/self/cmdline because the first allocations happen before main().
+// ts_offline is single-threaded, so the arena is not thread-safe.
+#ifdef __linux__
+static const uintptr_t kArenaBase = 0x100000000000ULL;
+static const uintptr_t kArenaSize = 1ULL << 38;
+static const size_t    kArenaPageSize = 4096;
+// Blocks larger than this are page-granular and their pages are
+// returned to the OS when freed.
+static const size_t    kArenaMaxSmallSize = 1 << 20;
+static const size_t    kArenaNumClasses = 64 + 11;
+
+// Precedes every block. Keeps the blocks 16-byte aligned.
+struct ArenaHeader {
+  size_t size;  // Size of the block including the header.
+  size_t pad;
+};
+
+struct ArenaFreeBlock {
+  ArenaFreeBlock *next;
+  size_t size;
+};
+
+static int             arena_state;  // 0: not known yet, 1: used, -1: not.
+static uintptr_t       arena_top;
+static ArenaFreeBlock *arena_free_lists[kArenaNumClasses];
+static ArenaFreeBlock *arena_free_large;
+
+static bool IsCheckpointFlag(const char *arg) {
+  return strstr(arg, "checkpoint_file=") || strstr(arg, "resume_from=");
+}
+
+static bool CheckpointFlagsGiven() {
+  static char cmdline[1 << 16];
+  int fd = open("/proc/self/cmdline", O_RDONLY);
+  if (fd < 0) return false;
+  ssize_t size = read(fd, cmdline, sizeof(cmdline) - 1);
+  close(fd);
+  if (size <= 0) return false;
+  cmdline[size] = 0;
+  // Skip argv[0].
+  for (char *arg = cmdline + strlen(cmdline) + 1; arg < cmdline + size;
+       arg += strlen(arg) + 1) {
+    if (IsCheckpointFlag(arg))
+      return true;
+  }
+  return false;
+}
+
+static void ArenaInit() {
+  arena_state = -1;
+  if (!CheckpointFlagsGiven())
+    return;
+  void *res = mmap((void*)kArenaBase, kArenaSize, PROT_READ | PROT_WRITE,
+                   MAP_PRIVATE | MAP_ANON | MAP_NORESERVE, -1, 0);
+  if (res != (void*)kArenaBase) {
+    // Printf allocates memory, so we can't use it here.
+    fprintf(stderr, "Error: ThreadSanitizerOffline: can't map the arena "
+            "for checkpoints at %p\n", (void*)kArenaBase);
+    exit(5);
+  }
+  arena_top = kArenaBase;
+  arena_state = 1;
+}
+
+INLINE bool ArenaIsUsed() {
+  if (arena_state == 0)
+    ArenaInit();
+  return arena_state > 0;
+}
+
+INLINE bool IsInArena(void *ptr) {
+  return (uintptr_t)ptr - kArenaBase < kArenaSize;
+}
+
+static uintptr_t ArenaBump(size_t size) {
+  if (arena_top + size > kArenaBase + kArenaSize) {
+    fprintf(stderr, "Error: ThreadSanitizerOffline: out of memory\n");
+    abort();
+  }
+  uintptr_t res = arena_top;
+  arena_top += size;
+  return res;
+}
+
+// Sizes up to 1K are rounded up to 16 bytes, larger ones to a power of two.
+static size_t ArenaSizeClass(size_t size, size_t *rounded) {
+  if (size <= 1024) {
+    *rounded = (size + 15) & ~(size_t)15;
+    return *rounded >> 4;
+  }
+  size_t cls = 65;
+  for (*rounded = 2048; *rounded < size; *rounded <<= 1)
+    cls++;
+  return cls;
+}
+
+static void *ArenaAllocate(size_t size) {
+  size_t total = size + sizeof(ArenaHeader);
+  uintptr_t block;
+  if (total <= kArenaMaxSmallSize) {
+    size_t cls = ArenaSizeClass(total, &total);
+    if (arena_free_lists[cls]) {
+      block = (uintptr_t)arena_free_lists[cls];
+      arena_free_lists[cls] = arena_free_lists[cls]->next;
+    } else {
+      block = ArenaBump(total);
+    }
+  } else {
+    total = (total + kArenaPageSize - 1) & ~(kArenaPageSize - 1);
+    // First fit among the freed large blocks not more than twice as big.
+    ArenaFreeBlock **prev = &arena_free_large;
+    while (*prev && ((*prev)->size < total || (*prev)->size > 2 * total))
+      prev = &(*prev)->next;
+    if (*prev) {
+      block = (uintptr_t)*prev;
+      total = (*prev)->size;
+      *prev = (*prev)->next;
+    } else {
+      arena_top = (arena_top + kArenaPageSize - 1) & ~(kArenaPageSize - 1);
+      block = ArenaBump(total);
+    }
+  }
+  ArenaHeader *header = (ArenaHeader*)block;
+  header->size = total;
+  header->pad = 0;
+  return header + 1;
+}
+
+static void ArenaFree(void *ptr) {
+  if (!ptr) return;
+  ArenaHeader *header = (ArenaHeader*)ptr - 1;
+  size_t size = header->size;
+  ArenaFreeBlock *block = (ArenaFreeBlock*)header;
+  if (size <= kArenaMaxSmallSize) {
+    size_t cls = ArenaSizeClass(size, &size);
+    block->next = arena_free_lists[cls];
+    arena_free_lists[cls] = block;
+  } else {
+    // The pages read as zeros until touched again.
+    madvise(block, size, MADV_DONTNEED);
+    block->next = arena_free_large;
+    block->size = size;
+    arena_free_large = block;
+  }
+}
+
+// The tables of ThreadSanitizer go to the arena too.
+void *AllocateZeroedTable(size_t size) {
+  if (!ArenaIsUsed()) {
+    void *res = mmap(NULL, size, PROT_READ | PROT_WRITE,
+                     MAP_PRIVATE | MAP_ANON, -1, 0);
+    CHECK(res != MAP_FAILED);
+    return res;
+  }
+  void *res = ArenaAllocate(size);
+  // Large blocks are either fresh or have been madvise'd when freed.
+  if (size + sizeof(ArenaHeader) <= kArenaMaxSmallSize)
+    memset(res, 0, size);
+  return res;
+}
+
+static void *OfflineAllocate(size_t size) {
+  if (ArenaIsUsed())
+    return ArenaAllocate(size);
+  void *res = malloc(size ? size : 1);
+  if (!res) {
+    fprintf(stderr, "Error: ThreadSanitizerOffline: out of memory\n");
+    abort();
+  }
+  return res;
+}
+
+static void OfflineFree(void *ptr) {
+  if (IsInArena(ptr))
+    ArenaFree(ptr);
+  else
+    free(ptr);
+}
+
+void *operator new(size_t size) { return OfflineAllocate(size); }
+void *operator new[](size_t size) { return OfflineAllocate(size); }
+void *operator new(size_t size, const std::nothrow_t&) throw() {
+  return OfflineAllocate(size);
+}
+void *operator new[](size_t size, const std::nothrow_t&) throw() {
+  return OfflineAllocate(size);
+}
+void operator delete(void *ptr) throw() { OfflineFree(ptr); }
+void operator delete[](void *ptr) throw() { OfflineFree(ptr); }
+void operator delete(void *ptr, const std::nothrow_t&) throw() {
+  OfflineFree(ptr);
+}
+void operator delete[](void *ptr, const std::nothrow_t&) throw() {
+  OfflineFree(ptr);
+}
+#endif  // __linux__
 //------------- Read binary file Utils ------------ {{{1
 static const int kBufSize = 65536;
 
@@ -297,26 +523,486 @@ void DecodeEventsFromFile(FILE *input, FILE *output) {
   Printf("INFO: ThreadSanitizer write %ld lines.\n", offline_line_n);
 }
 
+//------------- Checkpoints ------------ {{{1
+// A checkpoint is an image of the detector taken after the given number
+// of events: the static data of the binary and the non-zero pages of the
+// arena (threads, segments, VTSs, locksets, shadow memory, heap map, etc).
+// Resuming maps the image back, so it only works with the same binary
+// and the same shared libraries, at the same addresses. ts_offline
+// re-executes itself with ASLR disabled when checkpoints are used.
+// Flags are taken from the checkpoint, except for the suppressions,
+// error_exitcode and the checkpoint flags themselves.
+// A checkpoint also records a hash of the ts_offline binary and of the
+// input it has consumed, and is only resumed with the same ones.
+
+// FNV-1a.
+static const uint64_t kHashInit = 0xcbf29ce484222325ULL;
+
+static uint64_t HashBytes(uint64_t hash, const void *buf, size_t size) {
+  const unsigned char *p = (const unsigned char*)buf;
+  for (size_t i = 0; i < size; i++) {
+    hash ^= p[i];
+    hash *= 0x100000001b3ULL;
+  }
+  return hash;
+}
+
+// Hash of the events read so far when a checkpoint is to be written,
+// see ReadEventsFromFile().
+static uint64_t input_events_hash = kHashInit;
+
+static uint64_t HashEvent(uint64_t hash, Event *event) {
+  uint64_t fields[5] = {event->type(), (uint32_t)event->tid(), event->pc(),
+                        event->a(), event->info()};
+  return HashBytes(hash, fields, sizeof(fields));
+}
+
+#ifdef __linux__
+extern char __data_start[], _end[];
+extern FILE *G_out;
+
+struct CheckpointHeader {
+  char      magic[8];
+  uint64_t  n_events;    // The number of events handled.
+  int64_t   input_pos;   // Offset in the input or -1.
+  uint64_t  line_n;      // offline_line_n
+  uint64_t  input_hash;  // Of the first input_pos bytes if input_pos >= 0.
+  uint64_t  events_hash; // Of the first n_events events.
+  uint64_t  exe_hash;    // Of /proc/self/exe.
+  // The layout of the process that wrote the checkpoint.
+  uintptr_t code_addr;
+  uintptr_t libc_addr;
+  uintptr_t data_begin;
+  uintptr_t data_end;
+  uintptr_t arena_top;
+};
+
+// A run of pages of the arena.
+struct CheckpointRun {
+  uint64_t offset;  // From the arena base.
+  uint64_t size;    // 0 terminates the list.
+};
+
+static const char kCheckpointMagic[8] = {'T', 'S', 'O', 'F',
+                                         'F', 'C', 'K', '2'};
+
+// Hashes the first |size| bytes of the file |fd| without moving its offset.
+// Returns false if they can't be read.
+static bool HashFilePrefix(int fd, uint64_t size, uint64_t *hash) {
+  char buf[1 << 16];
+  uint64_t res = kHashInit;
+  for (uint64_t pos = 0; pos < size; ) {
+    size_t n = min<uint64_t>(size - pos, sizeof(buf));
+    ssize_t r = pread(fd, buf, n, pos);
+    if (r <= 0) return false;
+    res = HashBytes(res, buf, r);
+    pos += r;
+  }
+  *hash = res;
+  return true;
+}
+
+static uint64_t HashOfExe() {
+  uint64_t hash = 0;
+  int fd = open("/proc/self/exe", O_RDONLY);
+  struct stat st;
+  if (fd < 0 || fstat(fd, &st) != 0 ||
+      !HashFilePrefix(fd, st.st_size, &hash)) {
+    Printf("Error: can't read /proc/self/exe\n");
+    exit(5);
+  }
+  close(fd);
+  return hash;
+}
+
+static void FillCheckpointLayout(CheckpointHeader *hdr) {
+  hdr->code_addr = (uintptr_t)&ThreadSanitizerInit;
+  hdr->libc_addr = (uintptr_t)&fopen;
+  hdr->data_begin = (uintptr_t)__data_start;
+  hdr->data_end = (uintptr_t)_end;
+  hdr->exe_hash = HashOfExe();
+}
+
+static bool IsZeroPage(uintptr_t page) {
+  const uint64_t *p = (const uint64_t*)page;
+  for (size_t i = 0; i < kArenaPageSize / sizeof(*p); i++) {
+    if (p[i]) return false;
+  }
+  return true;
+}
+
+static void CheckpointWrite(FILE *f, const void *buf, size_t size) {
+  if (fwrite(buf, 1, size, f) != size) {
+    Printf("Error: can't write %s\n", G_flags->checkpoint_file.c_str());
+    exit(5);
+  }
+}
+
+static void WriteCheckpoint(FILE *input, uint64_t n_events) {
+  CHECK(ArenaIsUsed());
+  FILE *f = fopen(G_flags->checkpoint_file.c_str(), "wb");
+  if (f == NULL) {
+    Printf("Error: can't open %s\n", G_flags->checkpoint_file.c_str());
+    exit(5);
+  }
+  CheckpointHeader hdr;
+  memcpy(hdr.magic, kCheckpointMagic, sizeof(hdr.magic));
+  hdr.n_events = n_events;
+  hdr.input_pos = ftello(input);
+  if (hdr.input_pos >= 0 &&
+      !HashFilePrefix(fileno(input), hdr.input_pos, &hdr.input_hash))
+    hdr.input_pos = -1;
+  hdr.events_hash = input_events_hash;
+  hdr.line_n = offline_line_n;
+  FillCheckpointLayout(&hdr);
+  hdr.arena_top = arena_top;
+  // Nothing may be allocated until the image is written.
+  CheckpointWrite(f, &hdr, sizeof(hdr));
+  CheckpointWrite(f, __data_start, _end - __data_start);
+  uint64_t n_bytes = 0;
+  uintptr_t end = (arena_top + kArenaPageSize - 1) & ~(kArenaPageSize - 1);
+  for (uintptr_t page = kArenaBase; page < end; page += kArenaPageSize) {
+    if (IsZeroPage(page)) continue;
+    uintptr_t run_end = page + kArenaPageSize;
+    while (run_end < end && !IsZeroPage(run_end))
+      run_end += kArenaPageSize;
+    CheckpointRun run = {page - kArenaBase, run_end - page};
+    CheckpointWrite(f, &run, sizeof(run));
+    CheckpointWrite(f, (void*)page, run.size);
+    n_bytes += run.size;
+    page = run_end;
+  }
+  CheckpointRun last = {0, 0};
+  CheckpointWrite(f, &last, sizeof(last));
+  fclose(f);
+  Printf("INFO: ThreadSanitizerOffline: checkpoint after %ld events "
+         "(%ldK of %ldK) written to %s\n", n_events, n_bytes >> 10,
+         (end - kArenaBase) >> 10, G_flags->checkpoint_file.c_str());
+}
+
+static void CheckpointRead(FILE *f, void *buf, size_t size) {
+  if (fread(buf, 1, size, f) != size) {
+    // G_flags may be the one from the checkpoint here.
+    fprintf(stderr, "Error: ThreadSanitizerOffline: "
+            "truncated checkpoint\n");
+    exit(5);
+  }
+}
+
+// The flags that may be given together with --resume_from.
+// All other flags are taken from the checkpoint.
+static const char *kResumeFlags[] = {
+  "suppressions", "error_exitcode", "input_type",
+  "checkpoint_at", "checkpoint_file", "resume_from",
+};
+
+static void CheckResumeFlags(int argc, char *argv[]) {
+  for (int i = 1; i < argc; i++) {
+    const char *name = argv[i];
+    while (*name == '-') name++;
+    size_t len = strcspn(name, "=");
+    bool ok = false;
+    for (size_t j = 0; j < TS_ARRAY_SIZE(kResumeFlags); j++) {
+      if (strlen(kResumeFlags[j]) == len &&
+          strncmp(kResumeFlags[j], name, len) == 0)
+        ok = true;
+    }
+    if (!ok) {
+      Printf("Error: %s can't be used with --resume_from: the flags are "
+             "taken from the checkpoint except for --suppressions, "
+             "--error_exitcode, --input_type and the checkpoint flags\n",
+             argv[i]);
+      exit(5);
+    }
+  }
+}
+
+// Takes the flags that may differ from the checkpoint from the command line.
+static void ApplyResumeFlags(int argc, char *argv[]) {
+  FLAGS *flags = G_flags;
+  G_flags = new FLAGS;
+  vector<string> args(argv + 1, argv + argc);
+  ThreadSanitizerParseFlags(&args);
+  if (G_flags->input_type != flags->input_type) {
+    Printf("Error: the checkpoint has been written with --input_type=%s\n",
+           flags->input_type.c_str());
+    exit(5);
+  }
+  flags->suppressions = G_flags->suppressions;
+  flags->error_exitcode = G_flags->error_exitcode;
+  flags->checkpoint_at = G_flags->checkpoint_at;
+  flags->checkpoint_file = G_flags->checkpoint_file;
+  flags->resume_from = G_flags->resume_from;
+  delete G_flags;
+  G_flags = flags;
+  ThreadSanitizerReloadSuppressions();
+}
+
+// Restores the detector from G_flags->resume_from and positions the input
+// after the checkpointed events. Returns the number of these events.
+static uint64_t ResumeFromCheckpoint(FILE *input, EventReader event_reader_cb,
+                                     int argc, char *argv[]) {
+  CheckResumeFlags(argc, argv);
+  CHECK(ArenaIsUsed());
+  // No local may own arena memory: the arena is replaced below.
+  FILE *f = fopen(G_flags->resume_from.c_str(), "rb");
+  if (f == NULL) {
+    Printf("Error: can't open %s\n", G_flags->resume_from.c_str());
+    exit(5);
+  }
+  CheckpointHeader hdr, layout;
+  CheckpointRead(f, &hdr, sizeof(hdr));
+  FillCheckpointLayout(&layout);
+  if (memcmp(hdr.magic, kCheckpointMagic, sizeof(hdr.magic)) ||
+      hdr.exe_hash != layout.exe_hash ||
+      hdr.code_addr != layout.code_addr ||
+      hdr.libc_addr != layout.libc_addr ||
+      hdr.data_begin != layout.data_begin ||
+      hdr.data_end != layout.data_end) {
+    Printf("Error: %s was not written by this ts_offline binary "
+           "or its memory layout differs\n", G_flags->resume_from.c_str());
+    exit(5);
+  }
+
+  uint64_t input_hash;
+  if (hdr.input_pos >= 0 &&
+      HashFilePrefix(fileno(input), hdr.input_pos, &input_hash) &&
+      fseeko(input, hdr.input_pos, SEEK_SET) == 0) {
+    if (input_hash != hdr.input_hash) {
+      Printf("Error: the input differs from the one %s was written with\n",
+             G_flags->resume_from.c_str());
+      exit(5);
+    }
+  } else {
+    // Not a regular file: skip the events.
+    Event event;
+    uint64_t events_hash = kHashInit;
+    for (uint64_t i = 0; i < hdr.n_events; i++) {
+      if (!event_reader_cb(input, &event)) {
+        Printf("Error: the input has less than %ld events\n", hdr.n_events);
+        exit(5);
+      }
+      events_hash = HashEvent(events_hash, &event);
+    }
+    if (events_hash != hdr.events_hash) {
+      Printf("Error: the input differs from the one %s was written with\n",
+             G_flags->resume_from.c_str());
+      exit(5);
+    }
+  }
+
+  size_t data_size = hdr.data_end - hdr.data_begin;
+  char *data = (char*)malloc(data_size);
+  CHECK(data);
+  CheckpointRead(f, data, data_size);
+  FILE *out = G_out;
+  // From now on the arena holds the checkpoint: nothing may be allocated
+  // until the static data is restored as well.
+  madvise((void*)kArenaBase, arena_top - kArenaBase, MADV_DONTNEED);
+  CheckpointRun run;
+  while (CheckpointRead(f, &run, sizeof(run)), run.size != 0) {
+    if (run.offset + run.size > hdr.arena_top - kArenaBase + kArenaPageSize) {
+      fprintf(stderr, "Error: ThreadSanitizerOffline: bad checkpoint\n");
+      exit(5);
+    }
+    CheckpointRead(f, (void*)(kArenaBase + run.offset), run.size);
+  }
+  memcpy(__data_start, data, data_size);
+  G_out = out;
+  free(data);
+  fclose(f);
+
+  ApplyResumeFlags(argc, argv);
+  Printf("INFO: ThreadSanitizerOffline: resumed after %ld events from %s\n",
+         hdr.n_events, G_flags->resume_from.c_str());
+  return hdr.n_events;
+}
+
+// The checkpoints need the same addresses in every run.
+static void DisableAslrIfNeeded(char *argv[]) {
+  bool need = false;
+  for (char **arg = argv + 1; *arg; arg++) {
+    if (IsCheckpointFlag(*arg))
+      need = true;
+  }
+  if (!need) return;
+  int persona = personality(0xffffffff);
+  if (persona == -1 || (persona & ADDR_NO_RANDOMIZE)) return;
+  if (personality(persona | ADDR_NO_RANDOMIZE) == -1) return;
+  execv("/proc/self/exe", argv);
+}
+#else  // !__linux__
+static void WriteCheckpoint(FILE *input, uint64_t n_events) {
+  Printf("Error: checkpoints are only supported on Linux\n");
+  exit(5);
+}
+
+static uint64_t ResumeFromCheckpoint(FILE *input, EventReader event_reader_cb,
+                                     int argc, char *argv[]) {
+  Printf("Error: checkpoints are only supported on Linux\n");
+  exit(5);
+}
+
+static void DisableAslrIfNeeded(char *argv[]) { }
+#endif  // __linux__
+
+//------------- Read events ------------ {{{1
 static const uint32_t max_unknown_thread = 10000;
 
 static bool known_threads[max_unknown_thread] = {};
 
-INLINE void ReadEventsFromFile(FILE *file, EventReader event_reader_cb) {
+INLINE void HandleOneOfflineEvent(Event *event) {
+  uint32_t tid = event->tid();
+  if (event->type() == THR_START && tid < max_unknown_thread) {
+    known_threads[tid] = true;
+  }
+  if (tid >= max_unknown_thread || known_threads[tid]) {
+    ThreadSanitizerHandleOneEvent(event);
+  }
+}
+
+// Handles the events of the file. n_events is the number of events
+// already handled, non-zero when resuming from a checkpoint.
+INLINE void ReadEventsFromFile(FILE *file, EventReader event_reader_cb,
+                               uint64_t n_events) {
   Event event;
-  uint64_t n_events = 0;
-  offline_line_n = 0;
+  uint64_t checkpoint_at = 0;
+  if (G_flags->checkpoint_file.size() > 0)
+    checkpoint_at = G_flags->checkpoint_at;
+  if (n_events == 0)
+    offline_line_n = 0;
   while (event_reader_cb(file, &event)) {
     //event.Print();
     n_events++;
-    uint32_t tid = event.tid();
-    if (event.type() == THR_START && tid < max_unknown_thread) {
-      known_threads[tid] = true;
+    if (checkpoint_at)
+      input_events_hash = HashEvent(input_events_hash, &event);
+    HandleOneOfflineEvent(&event);
+    if (n_events == checkpoint_at)
+      WriteCheckpoint(file, n_events);
+  }
+  Printf("INFO: ThreadSanitizerOffline: %ld events read\n", n_events);
+}
+
+//------------- Merge per-thread event files ------------ {{{1
+// One input of the merge: a file and its next event.
+struct MergeStream {
+  FILE *file;
+  string name;
+  uint64_t line;
+  bool has_event;
+  Event event;
+  uint64_t seq;       // Sequence number of 'event', 0 if none.
+  uint64_t last_seq;  // The last sequence number read from the file.
+};
+
+// Reads the next event of the stream in the str format
+// with an optional '@seq' prefix.
+static void ReadOneMergeEvent(MergeStream *s) {
+  char name[1024];
+  uint32_t tid;
+  unsigned long pc, a, info;
+  s->has_event = false;
+  s->seq = 0;
+  SkipWhiteSpaceAndComments(s->file);
+  s->line++;
+  if (1 != fscanf(s->file, "%1023s", name))
+    return;
+  if (name[0] == '@') {
+    char *end = NULL;
+    s->seq = strtoull(name + 1, &end, 16);
+    if (s->seq == 0 || *end != 0 || 1 != fscanf(s->file, "%1023s", name)) {
+      Printf("Error: %s: event %ld: bad sequence number %s\n",
+             s->name.c_str(), s->line, name);
+      exit(5);
     }
-    if (tid >= max_unknown_thread || known_threads[tid]) {
-      ThreadSanitizerHandleOneEvent(&event);
+    if (s->seq <= s->last_seq) {
+      Printf("Error: %s: event %ld: sequence number %lx after %lx\n",
+             s->name.c_str(), s->line, s->seq, s->last_seq);
+      exit(5);
     }
+    s->last_seq = s->seq;
   }
-  Printf("INFO: ThreadSanitizerOffline: %ld events read\n", n_events);
+  if (4 != fscanf(s->file, "%x%lx%lx%lx", &tid, &pc, &a, &info)) {
+    Printf("Error: %s: event %ld: can't parse %s\n",
+           s->name.c_str(), s->line, name);
+    exit(5);
+  }
+  s->event.Init(EventNameToEventType(name), tid, pc, a, info);
+  s->has_event = true;
+}
+
+static void EmitMergedEvent(Event *event, FILE *output) {
+  if (output) {
+    fprintf(output, "%s %x %lx %lx %lx\n", kEventNames[event->type()],
+            event->tid(), (long unsigned int)event->pc(),
+            (long unsigned int)event->a(), (long unsigned int)event->info());
+  } else {
+    HandleOneOfflineEvent(event);
+  }
+}
+
+// Emits the events of the stream up to its next ordered event.
+static uint64_t EmitUnorderedEvents(MergeStream *s, FILE *output) {
+  uint64_t n_events = 0;
+  while (s->has_event && s->seq == 0) {
+    EmitMergedEvent(&s->event, output);
+    n_events++;
+    ReadOneMergeEvent(s);
+  }
+  return n_events;
+}
+
+// K-way merge of the per-thread files: a heap keyed by the sequence number
+// of the next ordered event of each file. Sequence numbers are assigned
+// at capture time in the real order of the synchronization events, so
+// the merged stream respects happens-before; concurrent events between
+// them may be reordered freely.
+void MergeEventsFromFiles(const vector<string> &names, FILE *output) {
+  typedef pair<uint64_t, size_t> HeapEntry;
+  priority_queue<HeapEntry, vector<HeapEntry>, greater<HeapEntry> > heap;
+  vector<MergeStream> streams(names.size());
+  uint64_t n_events = 0;
+  for (size_t i = 0; i < names.size(); i++) {
+    MergeStream *s = &streams[i];
+    s->name = names[i];
+    s->file = fopen(names[i].c_str(), "r");
+    if (s->file == NULL) {
+      Printf("Error: can't open %s\n", names[i].c_str());
+      exit(5);
+    }
+    s->line = 0;
+    s->last_seq = 0;
+    ReadOneMergeEvent(s);
+  }
+  // Events before the first ordered event of a file do not depend
+  // on other files.
+  for (size_t i = 0; i < streams.size(); i++) {
+    n_events += EmitUnorderedEvents(&streams[i], output);
+    if (streams[i].has_event)
+      heap.push(HeapEntry(streams[i].seq, i));
+  }
+  uint64_t last_seq = 0;
+  while (!heap.empty()) {
+    HeapEntry top = heap.top();
+    heap.pop();
+    MergeStream *s = &streams[top.second];
+    if (top.first == last_seq) {
+      Printf("Error: %s: event %ld: duplicate sequence number %lx\n",
+             s->name.c_str(), s->line, top.first);
+      exit(5);
+    }
+    last_seq = top.first;
+    EmitMergedEvent(&s->event, output);
+    n_events++;
+    ReadOneMergeEvent(s);
+    n_events += EmitUnorderedEvents(s, output);
+    if (s->has_event)
+      heap.push(HeapEntry(s->seq, top.second));
+  }
+  for (size_t i = 0; i < streams.size(); i++)
+    fclose(streams[i].file);
+  Printf("INFO: ThreadSanitizerOffline: %ld events merged from %ld files\n",
+         n_events, streams.size());
 }
 //------------- ThreadSanitizer exports ------------ {{{1
 
@@ -347,19 +1033,34 @@ string PcToRtnName(uintptr_t pc, bool demangle) {
 }
 //------------- main ---------------------------- {{{1
 int main(int argc, char *argv[]) {
+  DisableAslrIfNeeded(argv);
   Printf("INFO: ThreadSanitizerOffline r%s\n", TS_VERSION);
 
   InitEventTypeMap();
   g_pc_info_map = new map<uintptr_t, PcInfo>;
   G_flags = new FLAGS;
 
-  vector<string> args(argv + 1, argv + argc);
-  ThreadSanitizerParseFlags(&args);
-  ThreadSanitizerInit();
-
+  {
+    vector<string> args(argv + 1, argv + argc);
+    ThreadSanitizerParseFlags(&args);
+  }
   CHECK(G_flags);
-  if (G_flags->input_type == "bin") {
-    ReadEventsFromFile(stdin, ReadOneBinEventFromFile);
+  bool resume = G_flags->resume_from.size() > 0;
+  if ((resume || G_flags->checkpoint_file.size() > 0) &&
+      G_flags->input_type != "bin" && G_flags->input_type != "str") {
+    Printf("Error: checkpoints need --input_type=str or bin\n");
+    exit(5);
+  }
+  if (!resume)
+    ThreadSanitizerInit();
+
+  if (G_flags->input_type == "bin" || G_flags->input_type == "str") {
+    EventReader reader = G_flags->input_type == "bin" ?
+        ReadOneBinEventFromFile : ReadOneStrEventFromFile;
+    uint64_t n_events = 0;
+    if (resume)
+      n_events = ResumeFromCheckpoint(stdin, reader, argc, argv);
+    ReadEventsFromFile(stdin, reader, n_events);
   } else if (G_flags->input_type == "decode") {
     FILE* output;
     if (G_flags->log_file.size() > 0) {
@@ -368,8 +1069,15 @@ int main(int argc, char *argv[]) {
       output = stdout;
     }
     DecodeEventsFromFile(stdin, output);
-  } else if (G_flags->input_type == "str") {
-    ReadEventsFromFile(stdin, ReadOneStrEventFromFile);
+  } else if (G_flags->input_type == "merge") {
+    FILE* output = NULL;
+    if (G_flags->merge_output.size() > 0) {
+      output = fopen(G_flags->merge_output.c_str(), "w");
+      CHECK(output);
+    }
+    MergeEventsFromFiles(G_flags->merge_input, output);
+    if (output)
+      fclose(output);
   } else {
     Printf("Error: Unknown input_type value %s\n", G_flags->input_type.c_str());
     exit(5);
@@ -473,6 +473,10 @@ static INLINE void TLEBFlushUnlocked(ThreadLocalEventBuffer &tleb) {
       } else if (t.literace_sampling) {
         do_this_trace = !trace_info->LiteRaceSkipTraceRealTid(
             t.uniq_tid, t.literace_sampling);
+        if (!do_this_trace) {
+          ThreadSanitizerHandleSkippedTrace(t.uniq_tid, trace_info,
+                                            tleb.events+i);
+        }
       }
 
       size_t n = trace_info->n_mops();
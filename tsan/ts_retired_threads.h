@@ -0,0 +1,123 @@
+/* Copyright (c) 2008-2010, Google Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ *     * Neither the name of Google Inc. nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+// This file is part of ThreadSanitizer, a dynamic data race detector.
+#ifndef TS_RETIRED_THREADS_
+#define TS_RETIRED_THREADS_
+
+#include "ts_util.h"
+#include "ts_lock.h"
+
+// -------- RetiredThreads ------ {{{1
+// The final clocks of the retired threads, used by the dead thread
+// compaction of VTS (see VTS::RetireThread()).
+// The thread retired in generation G (1-based) is Get(G). The entries of
+// one tid are chained through prev_gen, so ImplicitClk() finds the final
+// clock of the last retirement of a tid not later than a given generation.
+//
+// Retire() must be serialized by the caller. The other methods may run
+// concurrently with it: the table is a fixed directory of chunks which
+// never move, and an entry is written before the counters that make it
+// reachable are published.
+class RetiredThreads {
+ public:
+  struct Entry {
+    int32_t tid;
+    int32_t clk;       // The final clock.
+    int32_t prev_gen;  // Previous retirement of the same tid, or 0.
+  };
+
+  RetiredThreads(int32_t max_n_threads, size_t chunk_size, size_t max_chunks)
+    : chunk_size_(chunk_size),
+      max_chunks_(max_chunks),
+      max_n_threads_(max_n_threads),
+      size_(0) {
+    chunks_ = new Entry *[max_chunks_];
+    memset(chunks_, 0, sizeof(*chunks_) * max_chunks_);
+    last_gen_ = new uintptr_t[max_n_threads_];
+    memset(last_gen_, 0, sizeof(*last_gen_) * max_n_threads_);
+  }
+
+  ~RetiredThreads() {
+    for (size_t i = 0; i < max_chunks_; i++) {
+      delete [] chunks_[i];
+    }
+    delete [] chunks_;
+    delete [] last_gen_;
+  }
+
+  // Give |tid| the next generation. Returns false if the table is full,
+  // in which case the thread is not retired: its entries simply stay
+  // explicit in every VTS.
+  bool Retire(int32_t tid, int32_t final_clk) {
+    CHECK(tid >= 0 && tid < max_n_threads_);
+    uintptr_t gen = size_;
+    size_t chunk = gen / chunk_size_;
+    if (chunk >= max_chunks_) return false;
+    if (chunks_[chunk] == NULL) {
+      chunks_[chunk] = new Entry[chunk_size_];
+    }
+    Entry &e = chunks_[chunk][gen % chunk_size_];
+    e.tid = tid;
+    e.clk = final_clk;
+    e.prev_gen = last_gen_[tid];
+    ReleaseStore(&size_, gen + 1);
+    ReleaseStore(&last_gen_[tid], gen + 1);
+    return true;
+  }
+
+  // The number of retired threads, i.e. the last generation.
+  int32_t size() const {
+    return *(volatile uintptr_t*)&size_;
+  }
+
+  const Entry &Get(int32_t gen) const {
+    DCHECK(gen > 0 && gen <= size());
+    return chunks_[(gen - 1) / chunk_size_][(gen - 1) % chunk_size_];
+  }
+
+  // Clock of |tid| implied by a VTS of generation |gen| with no entry for it.
+  int32_t ImplicitClk(int32_t tid, int32_t gen) const {
+    if (gen == 0) return 0;
+    int32_t g = *(volatile uintptr_t*)&last_gen_[tid];
+    while (g > gen) {
+      g = Get(g).prev_gen;
+    }
+    return g ? Get(g).clk : 0;
+  }
+
+ private:
+  const size_t chunk_size_;
+  const size_t max_chunks_;
+  const int32_t max_n_threads_;
+  Entry **chunks_;  // Chunks of the table indexed by gen - 1.
+  uintptr_t size_;
+  uintptr_t *last_gen_;  // Indexed by tid.
+};
+
+// end. {{{1
+#endif  // TS_RETIRED_THREADS_
+// vim:shiftwidth=2:softtabstop=2:expandtab:tw=80
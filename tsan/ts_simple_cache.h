@@ -105,6 +105,65 @@ class IntPairToBoolCache {
   uint32_t arr_[kSize * 2];
 };
 
+// -------- ConcurrentIntPairToBoolCache ------ {{{1
+// Same as IntPairToBoolCache, but may be accessed by several threads without
+// a lock and is flushed by bumping a generation instead of a memset.
+//
+// An entry is two 64-bit words: 'key' holds {a, b, val} and 'check' holds
+// the generation xor-ed with a hash of 'key'. A lookup which sees a torn
+// entry (key and check from different writes) or an entry from an old
+// generation fails the check and is treated as a miss.
+// The table is split into kShards shards of kShardSize entries; the shard is
+// chosen by b so that lookups for one VTS touch a small part of the table.
+template <int32_t kShards, int32_t kShardSize>
+class ConcurrentIntPairToBoolCache {
+ public:
+  ConcurrentIntPairToBoolCache() : generation_(1) {
+    memset(arr_, 0, sizeof(arr_));
+  }
+  void Flush() {
+    generation_++;
+  }
+  void Insert(uint32_t a, uint32_t b, bool val) {
+    DCHECK((int32_t)b >= 0);
+    Entry *e = &arr_[idx(a, b)];
+    uint64_t key = MakeKey(a, b, val);
+    uint64_t gen = generation_;
+    e->key = key;
+    e->check = gen ^ Mix(key);
+  }
+  bool Lookup(uint32_t a, uint32_t b, bool *val) {
+    DCHECK((int32_t)b >= 0);
+    Entry *e = &arr_[idx(a, b)];
+    uint64_t key = e->key;
+    uint64_t check = e->check;
+    if ((key | 1) != MakeKey(a, b, true)) return false;
+    if ((check ^ Mix(key)) != generation_) return false;
+    *val = key & 1;
+    return true;
+  }
+ private:
+  struct Entry {
+    volatile uint64_t key;
+    volatile uint64_t check;
+  };
+  static uint64_t MakeKey(uint32_t a, uint32_t b, bool val) {
+    return ((uint64_t)a << 32) | (b << 1) | val;
+  }
+  static uint64_t Mix(uint64_t x) {
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdULL;
+    x ^= x >> 33;
+    return x;
+  }
+  static uint32_t idx(uint32_t a, uint32_t b) {
+    uint32_t shard = b % kShards;
+    return shard * kShardSize + (a ^ ((b >> 16) | (b << 16))) % kShardSize;
+  }
+  volatile uint64_t generation_;
+  Entry arr_[kShards * kShardSize];
+};
+
 // end. {{{1
 #endif  // TS_SIMPLE_CACHE_
 // vim:shiftwidth=2:softtabstop=2:expandtab:tw=80
@@ -93,9 +93,19 @@ struct Stats : private ThreadLocalStats {
            vts_total_create,
            vts_total_create / (vts_create_small + vts_create_big + 1),
            vts_total_delete);
+    Printf("   LightSync: acquire: %'ld (no-op: %'ld); "
+           "release: join: %'ld; clone: %'ld; no-op: %'ld\n",
+           light_sync_acquire, light_sync_acquire_noop,
+           light_sync_release_join, light_sync_release_clone,
+           light_sync_release_noop);
     Printf("   n_seg_hb        = %'ld\n", n_seg_hb);
+    Printf("   VTS: retired threads: %'ld (table full: %'ld); "
+           "entries removed: %'ld; tids reused: %'ld\n",
+           vts_retired_threads, vts_retire_failed,
+           vts_retired_entries_removed, n_tids_reused);
     Printf("   n_vts_hb        = %'ld\n", n_vts_hb);
     Printf("   n_vts_hb_cached = %'ld\n", n_vts_hb_cached);
+    Printf("   n_vts_hb_across_gen = %'ld\n", n_vts_hb_across_gen);
     Printf("   memory access:\n"
            "     1: %'ld / %'ld\n"
            "     2: %'ld / %'ld\n"
@@ -180,6 +190,8 @@ struct Stats : private ThreadLocalStats {
            ls_remove_from_singleton, ls_remove_from_multi);
     Printf("   LockSet cache: add : %'ld; rem : %'ld; fast: %'ld\n",
            ls_add_cache_hit, ls_rem_cache_hit, ls_cache_fast);
+    Printf("   LockSet intersection: signature: %'ld; exact: %'ld\n",
+           ls_intersection_fast, ls_intersection_exact);
     Printf("   LockSet size: 2: %'ld 3: %'ld 4: %'ld 5: %'ld other: %'ld\n",
            ls_size_2, ls_size_3, ls_size_4, ls_size_5, ls_size_other);
   }
@@ -244,12 +256,13 @@ struct Stats : private ThreadLocalStats {
 
   uintptr_t n_vts_hb;
   uintptr_t n_vts_hb_cached;
+  uintptr_t n_vts_hb_across_gen;
   uintptr_t n_seg_hb;
 
   uintptr_t ls_add_to_empty, ls_add_to_singleton, ls_add_to_multi,
             ls_remove_from_singleton, ls_remove_from_multi,
             ls_add_cache_hit, ls_rem_cache_hit,
-            ls_cache_fast,
+            ls_cache_fast, ls_intersection_fast, ls_intersection_exact,
             ls_size_2, ls_size_3, ls_size_4, ls_size_5, ls_size_other;
 
   uintptr_t cache_new_line;
@@ -263,6 +276,13 @@ struct Stats : private ThreadLocalStats {
   uintptr_t vts_create_big, vts_create_small,
             vts_clone, vts_delete_small, vts_delete_big,
             vts_total_delete, vts_total_create;
+  uintptr_t vts_retired_threads, vts_retire_failed,
+            vts_retired_entries_removed;
+  uintptr_t n_tids_reused;
+
+  uintptr_t light_sync_acquire, light_sync_acquire_noop,
+            light_sync_release_join, light_sync_release_clone,
+            light_sync_release_noop;
 
   uintptr_t ss_create, ss_reuse, ss_find, ss_recycle;
   uintptr_t ss_size_2, ss_size_3, ss_size_4, ss_size_other;
@@ -91,9 +91,10 @@ struct MopInfo {
 // 1 means handle *almost* all accesses.
 // ...
 // 31 means very aggressive sampling (skip a lot of accesses).
-
 //
-// Note: ANNOTATE_PUBLISH_MEMORY() does not work with sampling... :(
+// Accesses from skipped traces to published memory
+// (ANNOTATE_PUBLISH_MEMORY) are still handled,
+// see ThreadSanitizerHandleSkippedTrace().
 
 struct LiteRaceCounters {
   uint32_t counter;
@@ -220,6 +220,28 @@ long my_strtol(const char *str, char **end, int base) {
 // malloc to be called concurrently.
 MallocCostCenterStack g_malloc_stack;
 
+#if defined(TS_VALGRIND) || defined(_MSC_VER)
+void *AllocateZeroedTable(size_t size) {
+  void *res = new int8_t[size];
+  memset(res, 0, size);
+  return res;
+}
+#elif defined(TS_OFFLINE) && defined(__linux__)
+// Provided by ts_offline.cc, which keeps all of its state in one arena
+// so that the state can be checkpointed.
+#else
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+void *AllocateZeroedTable(size_t size) {
+  // Use the syscall directly so that the mmap() interceptors do not see it.
+  void *res = (void*)syscall(SYS_mmap, NULL, size, PROT_READ | PROT_WRITE,
+                             MAP_PRIVATE | MAP_ANON, -1, 0);
+  CHECK(res != MAP_FAILED);
+  return res;
+}
+#endif
+
 size_t GetVmSizeInMb() {
 #ifdef VGO_linux
   const char *path ="/proc/self/statm";  // see 'man proc'
@@ -366,6 +366,11 @@ string NormalizeFunctionName(const string &mangled_fname);
 
 string ThreadSanitizerReadFileToString(const string &file_name, bool die_if_failed);
 
+// Allocate a large zero-filled table which is never freed.
+// Where possible this is an anonymous mapping: its pages are not touched
+// until used and stay shared with a forked child until written.
+void *AllocateZeroedTable(size_t size);
+
 // Get the current memory footprint of myself (parse /proc/self/status).
 size_t GetVmSizeInMb();
 size_t GetMemoryLimitInMbFromProcSelfLimits();
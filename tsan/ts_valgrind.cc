@@ -366,9 +366,15 @@ INLINE void FlushMops(ValgrindThread *thr, bool keep_trace_info = false) {
     thr->trace_info = NULL;
   }
 
-  if (global_ignore || thr->ignore_accesses ||
-       (thr->literace_sampling &&
-        t->LiteRaceSkipTraceRealTid(thr->zero_based_uniq_tid, thr->literace_sampling))) {
+  if (global_ignore || thr->ignore_accesses) {
+    thr->trace_info = NULL;
+    return;
+  }
+
+  if (thr->literace_sampling &&
+      t->LiteRaceSkipTraceRealTid(thr->zero_based_uniq_tid,
+                                  thr->literace_sampling)) {
+    ThreadSanitizerHandleSkippedTrace(thr->ts_thread, t, thr->tleb);
     thr->trace_info = NULL;
     return;
   }
@@ -138,6 +138,11 @@ static map<tid_t, pthread_barrier_t*> ChildThreadStartBarriers;
 // How about using barriers here as well?
 static map<pthread_t, pthread_cond_t*> InitConds;
 static map<tid_t, pthread_cond_t*> FinishConds;
+// Tids of the threads joined by a thread. They are reused by the threads
+// it creates afterwards, see InitTid().
+static map<tid_t, vector<tid_t> > ReusableTids;
+// How many of the most recently joined tids InitTid() tries.
+static const size_t kMaxTidReuseCandidates = 16;
 static tid_t max_tid;
 
 static __thread  sigset_t glob_sig_blocked, glob_sig_old;
@@ -484,7 +489,11 @@ INLINE void RPut(EventType type, tid_t tid, pc_t pc,
   }
 }
 
+static void PrintFuncDispatchStats();
+
 void finalize() {
+  if (G_flags->show_stats)
+    PrintFuncDispatchStats();
   ENTER_RTL();
   // atexit hooks are ran from a single thread.
   ThreadSanitizerFini();
@@ -670,6 +679,7 @@ static bool initialize() {
   memset(__tsan_shadow_stack.pcs_, 0,
       kCallStackReserve * sizeof(__tsan_shadow_stack.pcs_[0]));
   __tsan_shadow_stack.end_ = __tsan_shadow_stack.pcs_ + kCallStackReserve;
+  CallStackRehash(&__tsan_shadow_stack);
   // Only one thread exists at this moment.
   G_flags = new FLAGS;
   vector<string> args;
@@ -770,6 +780,70 @@ INLINE void UnsafeInitTidCommon() {
   INIT = 1;
 }
 
+// Descriptors of the functions compiled with an uninstrumented clone
+// (gcc plugin option -fplugin-arg-tsan-clones). The plugin places them
+// into the __tsan_funcs section; the instrumented version of a function
+// is called only while its 'enabled' is non-zero. 'mops' is the number
+// of instrumented memory accesses in the function, 'uninst_calls' is
+// incremented (non-atomically) on each call that goes to the clone.
+struct TsanFuncDesc {
+  void *func;
+  uintptr_t enabled;
+  uintptr_t mops;
+  uintptr_t uninst_calls;
+};
+
+extern TsanFuncDesc __start___tsan_funcs[] __attribute__((weak));
+extern TsanFuncDesc __stop___tsan_funcs[] __attribute__((weak));
+
+// Turns off instrumentation for ignored functions and, with
+// --func_sampling=N, for all but each N-th function.
+// Should be called under the global lock.
+static void InitFuncDispatch() {
+  if (__start___tsan_funcs == NULL || __stop___tsan_funcs == NULL)
+    return;
+  int num_funcs = 0;
+  int num_disabled = 0;
+  uintptr_t num_mops = 0;
+  uintptr_t num_disabled_mops = 0;
+  for (TsanFuncDesc *desc = __start___tsan_funcs;
+       desc != __stop___tsan_funcs; desc++, num_funcs++) {
+    bool enabled = ThreadSanitizerWantToInstrumentSblock(
+        (uintptr_t)desc->func);
+    if (enabled && G_flags->func_sampling > 1)
+      enabled = (num_funcs % G_flags->func_sampling) == 0;
+    desc->enabled = enabled;
+    num_disabled += !enabled;
+    num_mops += desc->mops;
+    if (!enabled)
+      num_disabled_mops += desc->mops;
+  }
+  if (G_flags->show_stats) {
+    Printf("Uninstrumented clones used for %d of %d functions "
+           "(%ld of %ld instrumented memory accesses)\n",
+           num_disabled, num_funcs,
+           (long)num_disabled_mops, (long)num_mops);
+  }
+}
+
+// Prints how much instrumentation the uninstrumented clones have saved:
+// the number of calls that went to a clone and, as an estimate of the
+// __tsan_handle_mop calls avoided, the sum of calls * mops.
+static void PrintFuncDispatchStats() {
+  if (__start___tsan_funcs == NULL || __stop___tsan_funcs == NULL)
+    return;
+  uintptr_t num_calls = 0;
+  uintptr_t num_skipped_mops = 0;
+  for (TsanFuncDesc *desc = __start___tsan_funcs;
+       desc != __stop___tsan_funcs; desc++) {
+    num_calls += desc->uninst_calls;
+    num_skipped_mops += desc->uninst_calls * desc->mops;
+  }
+  Printf("Calls to uninstrumented clones: %ld "
+         "(~%ld instrumented memory accesses skipped)\n",
+         (long)num_calls, (long)num_skipped_mops);
+}
+
 static void InitRTLAndTid0() {
   CHECK(INIT == 0);
   GIL scoped;
@@ -786,6 +860,7 @@ static void InitRTLAndTid0() {
   max_tid = 1;
   UnsafeInitTidCommon();
   __tsan::SymbolizeInit();
+  InitFuncDispatch();
 }
 
 extern "C" void __attribute__((visibility("default")))
@@ -797,13 +872,34 @@ __tsan_init() {
   InitRTLAndTid0();
 }
 
-INLINE void InitTid() {
+INLINE void InitTid(tid_t parent) {
   DCHECK(RTL_INIT == 1);
   GIL scoped;
   // thread initialization
   pthread_t pt = pthread_self();
+  // The parent is blocked in pthread_create() until we are initialized,
+  // so it has joined the threads in ReusableTids[parent] before creating us.
+  // Everything they did happens-before us, and ThreadSanitizer can let us
+  // continue the clock of one of them once no report may mention it.
   INFO.tid = max_tid;
-  max_tid++;
+  map<tid_t, vector<tid_t> >::iterator reusable = ReusableTids.find(parent);
+  if (reusable != ReusableTids.end()) {
+    vector<tid_t> &tids = reusable->second;
+    size_t n_tries = min(tids.size(), kMaxTidReuseCandidates);
+    for (size_t i = 0; i < n_tries; i++) {
+      size_t idx = tids.size() - 1 - i;
+      ENTER_RTL();
+      bool is_reusable = ThreadSanitizerTidIsReusable(tids[idx]);
+      LEAVE_RTL();
+      if (is_reusable) {
+        INFO.tid = tids[idx];
+        tids.erase(tids.begin() + idx);
+        break;
+      }
+    }
+  }
+  if (INFO.tid == max_tid)
+    max_tid++;
   // TODO(glider): remove InitConds.
   if (InitConds.find(pt) != InitConds.end()) {
     __real_pthread_cond_signal(InitConds[pt]);
@@ -857,7 +953,7 @@ void *pthread_callback(void *arg) {
 
   CHECK((PTH_INIT == 1) && (RTL_INIT == 1));
   CHECK(INIT == 0);
-  InitTid();
+  InitTid(((callback_arg*)arg)->parent);
   DECLARE_TID_AND_PC();
   DCHECK(INIT == 1);
   DCHECK(tid != 0);
@@ -915,6 +1011,7 @@ void *pthread_callback(void *arg) {
 
   memset(__tsan_shadow_stack.pcs_, 0, kCallStackReserve * sizeof(__tsan_shadow_stack.pcs_[0]));
   __tsan_shadow_stack.end_ = __tsan_shadow_stack.pcs_ + kCallStackReserve;
+  CallStackRehash(&__tsan_shadow_stack);
   SPut(THR_START, INFO.tid, (pc_t) &__tsan_shadow_stack, 0, parent);
 
   INFO.thread = ThreadSanitizerGetThreadByTid(INFO.tid);
@@ -1020,6 +1117,7 @@ void unsafe_forget_thread(tid_t tid, tid_t from) {
   InitConds.erase(pt);
   FinishConds.erase(tid);
   ThreadInfoMap.erase(pt);
+  ReusableTids.erase(tid);
 }
 
 // To declare a wrapper for foo(bar) you should:
@@ -1687,7 +1785,7 @@ sem_t *__wrap_sem_open(const char *name, int oflag,
   if ((oflag & O_CREAT) &&
       value > 0 &&
       result != SEM_FAILED) {
-    SPut(SIGNAL, tid, pc, (uintptr_t)result, 0);
+    SPut(SEM_POST, tid, pc, (uintptr_t)result, 0);
   }
   RPut(RTN_EXIT, tid, pc, 0, 0);
   return result;
@@ -1698,10 +1796,10 @@ static int tsan_sem_wait(sem_t *sem) {
   RPut(RTN_CALL, tid, pc, (uintptr_t)__real_sem_wait, 0);
   // Need to always signal on the semaphore, because sem_wait() changes its
   // state.
-  SPut(SIGNAL, tid, pc, (uintptr_t)sem, 0);
+  SPut(SEM_POST, tid, pc, (uintptr_t)sem, 0);
   int result = __real_sem_wait(sem);
   if (result == 0) {
-    SPut(WAIT, tid, pc, (uintptr_t)sem, 0);
+    SPut(SEM_WAIT, tid, pc, (uintptr_t)sem, 0);
   }
   RPut(RTN_EXIT, tid, pc, 0, 0);
   return result;
@@ -1717,7 +1815,7 @@ int tsan_sem_timedwait(sem_t *sem, const struct timespec *abs_timeout) {
   RPut(RTN_CALL, tid, pc, (uintptr_t)__real_sem_timedwait, 0);
   int result = __real_sem_timedwait(sem, abs_timeout);
   if (result == 0) {
-    SPut(WAIT, tid, pc, (uintptr_t)sem, 0);
+    SPut(SEM_WAIT, tid, pc, (uintptr_t)sem, 0);
   }
   RPut(RTN_EXIT, tid, pc, 0, 0);
   return result;
@@ -1748,12 +1846,12 @@ int tsan_sem_trywait(sem_t *sem) {
       errno = EAGAIN;
       return -1;
     } else {
-      SPut(SIGNAL, tid, pc, (uintptr_t)sem, 0);
+      SPut(SEM_POST, tid, pc, (uintptr_t)sem, 0);
     }
   }
   int result = __real_sem_trywait(sem);
   if (result == 0) {
-    SPut(WAIT, tid, pc, (uintptr_t)sem, 0);
+    SPut(SEM_WAIT, tid, pc, (uintptr_t)sem, 0);
   }
   RPut(RTN_EXIT, tid, pc, 0, 0);
   LEAVE_RTL();
@@ -1768,7 +1866,7 @@ int __wrap_sem_trywait(sem_t *sem) {
 int tsan_sem_post(sem_t *sem) {
   DECLARE_TID_AND_PC();
   RPut(RTN_CALL, tid, pc, (uintptr_t)__real_sem_post, 0);
-  SPut(SIGNAL, tid, pc, (uintptr_t)sem, 0);
+  SPut(SEM_POST, tid, pc, (uintptr_t)sem, 0);
   int result = __real_sem_post(sem);
   RPut(RTN_EXIT, tid, pc, 0, 0);
   return result;
@@ -1783,7 +1881,7 @@ static int tsan_sem_getvalue(sem_t *sem, int *value) {
   DECLARE_TID_AND_PC();
   RPut(RTN_CALL, tid, pc, (uintptr_t)__real_sem_getvalue, 0);
   int result = __real_sem_getvalue(sem, value);
-  SPut(WAIT, tid, pc, (uintptr_t)sem, 0);
+  SPut(SEM_WAIT, tid, pc, (uintptr_t)sem, 0);
   RPut(RTN_EXIT, tid, pc, 0, 0);
   return result;
 }
@@ -2182,6 +2280,10 @@ int __wrap_pthread_join(pthread_t thread, void **value_ptr) {
     DCHECK(joined_tid > 0);
     pc_t pc = (pc_t)__builtin_return_address(0);
     SPut(THR_JOIN_AFTER, tid, pc, joined_tid, 0);
+    if (G_flags->reuse_tids) {
+      GIL scoped;
+      ReusableTids[tid].push_back(joined_tid);
+    }
   }
   RPut(RTN_EXIT, tid, pc, 0, 0);
   return result;
@@ -2218,7 +2320,7 @@ static int tsan_pthread_spin_lock(pthread_spinlock_t *lock) {
   RPut(RTN_CALL, tid, pc, mypc, 0);
   int result = __real_pthread_spin_lock(lock);
   if (result == 0) {
-    SPut(WRITER_LOCK, tid, mypc, (uintptr_t)lock, 0);
+    SPut(SPIN_LOCK, tid, mypc, (uintptr_t)lock, 0);
   }
   RPut(RTN_EXIT, tid, pc, 0, 0);
   return result;
@@ -2235,7 +2337,7 @@ static int tsan_pthread_spin_trylock(pthread_spinlock_t *lock) {
   RPut(RTN_CALL, tid, pc, mypc, 0);
   int result = __real_pthread_spin_trylock(lock);
   if (result == 0) {
-    SPut(WRITER_LOCK, tid, mypc, (uintptr_t)lock, 0);
+    SPut(SPIN_LOCK, tid, mypc, (uintptr_t)lock, 0);
   }
   RPut(RTN_EXIT, tid, pc, 0, 0);
   return result;
@@ -2250,7 +2352,7 @@ static int tsan_pthread_spin_unlock(pthread_spinlock_t *lock) {
   DECLARE_TID_AND_PC();
   pc_t const mypc = (pc_t)__real_pthread_spin_unlock;
   RPut(RTN_CALL, tid, pc, mypc, 0);
-  SPut(UNLOCK, tid, mypc, (uintptr_t)lock, 0);
+  SPut(SPIN_UNLOCK, tid, mypc, (uintptr_t)lock, 0);
   int result = __real_pthread_spin_unlock(lock);
   RPut(RTN_EXIT, tid, pc, 0, 0);
   return result;
@@ -2512,21 +2614,26 @@ pid_t __wrap_fork() {
   result = __real_fork();
   DDPrintf("After fork() in process %d\n", getpid());
   if (result == 0) {
-    // Ignore all accesses in the child process. If someone is flushing the
-    // TLEB in a thread under TSLock, and we're doing fork() in another thread,
-    // then TSLock will remain locked forever in the child process, and trying
-    // to analyze further memory accesses will cause a deadlock.
-    // If someone is trying to take locks or spawn more threads in the child
-    // process, he's very likely to have problems already -- let's not bother
-    // him with race reports.
-
-    // TODO(glider): Chrome does this often. Maybe it's better to re-initialize
-    // ThreadSanitizer and some RTL parts upon fork().
-
-    //thread_local_ignore = 1;
-    // Haha, all our resources that address the TLS of other threads are valid
+    // Keep analyzing the child process. TSLock is held by this thread
+    // across fork() (see ThreadSanitizerLockAcquire() above), so no other
+    // thread could have left it locked in the child.
+    // The resources that address the TLS of other threads are valid
     // no more!
     FORKED_CHILD = true;
+    // The child inherits the analyzed state of the parent. All other threads
+    // are gone: ThreadSanitizer joins them, and their tids may be reused by
+    // the threads we create later.
+    ThreadSanitizerHandleForkInChild(INFO.tid);
+    vector<tid_t> other_tids;
+    for (map<tid_t, pthread_t>::iterator it = PThreads.begin();
+         it != PThreads.end(); ++it) {
+      if (it->first != INFO.tid) other_tids.push_back(it->first);
+    }
+    for (size_t i = 0; i < other_tids.size(); i++) {
+      unsafe_forget_thread(other_tids[i], INFO.tid);
+      if (G_flags->reuse_tids && other_tids[i] != 0)
+        ReusableTids[INFO.tid].push_back(other_tids[i]);
+    }
     //DECLARE_TID_AND_PC();
     //SPut(FLUSH_STATE, tid, pc, 0, 0);
     LEAVE_RTL();
@@ -2776,13 +2883,26 @@ int __wrap_lockf64(int fd, int cmd, off64_t len) {
   return result;
 }
 
+// Happens-before arc between epoll_ctl() and epoll_wait() {{{1
+// Each registration on an epoll fd has its own sync object, so that
+// epoll_wait() acquires only the clocks of the registrations it reports ready
+// rather than those of every producer ever registered on that epoll fd.
+// epoll_wait() returns nothing but the user data of a ready registration,
+// so the registration is identified by the (epfd, data) pair.
+uintptr_t EpollRegistrationMagic(int epfd, uint64_t data) {
+  static char tab[1021];
+  uint64_t key = data * 0x9E3779B97F4A7C15ULL + (uint64_t)epfd;
+  return (uintptr_t)&tab[(key ^ (key >> 32)) % sizeof(tab)];
+}
+
 extern "C"
 int __wrap_epoll_ctl(int epfd, int op, int fd, struct epoll_event *event) {
   if (IN_RTL) return __real_epoll_ctl(epfd, op, fd, event);
   DECLARE_TID_AND_PC();
   RPut(RTN_CALL, tid, pc, (uintptr_t)__real_epoll_ctl, 0);
   ENTER_RTL();
-  SPut(SIGNAL, tid, pc, FdMagic(epfd), 0);
+  if ((op == EPOLL_CTL_ADD || op == EPOLL_CTL_MOD) && event)
+    SPut(SIGNAL, tid, pc, EpollRegistrationMagic(epfd, event->data.u64), 0);
   int result = __real_epoll_ctl(epfd, op, fd, event);
   LEAVE_RTL();
   RPut(RTN_EXIT, tid, pc, 0, 0);
@@ -2796,7 +2916,8 @@ static int tsan_epoll_wait(int epfd, struct epoll_event *events,
   ENTER_RTL();
   int result = __real_epoll_wait(epfd, events, maxevents, timeout);
   int err = errno;
-  SPut(WAIT, tid, pc, FdMagic(epfd), 0);
+  for (int i = 0; i < result; i++)
+    SPut(WAIT, tid, pc, EpollRegistrationMagic(epfd, events[i].data.u64), 0);
   LEAVE_RTL();
   RPut(RTN_EXIT, tid, pc, 0, 0);
   errno = err;
@@ -2957,6 +3078,7 @@ void rtn_call(void *addr, void *pc) {
 #ifdef GCC
   __tsan_shadow_stack.end_[-1] = (uintptr_t)pc;
 #endif
+  CallStackPushHash(&__tsan_shadow_stack);
   __tsan_shadow_stack.end_[0] = (uintptr_t)addr;
   __tsan_shadow_stack.end_++;
   DCHECK(__tsan_shadow_stack.end_ > __tsan_shadow_stack.pcs_);
@@ -2968,6 +3090,7 @@ void rtn_exit() {
   CHECK(__tsan_shadow_stack.end_ > __tsan_shadow_stack.pcs_);
   DCHECK((size_t)(__tsan_shadow_stack.end_ - __tsan_shadow_stack.pcs_) < kMaxCallStackSize);
   __tsan_shadow_stack.end_--;
+  CallStackPopHash(&__tsan_shadow_stack);
   if (DEBUG_SHADOW_STACK) {
     *__tsan_shadow_stack.end_ = kInvalidStackFrame;
     validate_shadow_stack(kInvalidStackFrame);
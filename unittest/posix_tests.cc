@@ -44,6 +44,7 @@
 #include <sys/socket.h>
 #include <sys/uio.h>
 #include <sys/un.h>
+#include <sys/wait.h>
 #include <unistd.h>
 
 #include <queue>
@@ -1114,6 +1115,44 @@ TEST(Signals, PositiveTests_RaceInSignal) {
 
 }  // namespace;
 
+namespace NegativeTests_ForkInheritsState {  // {{{1
+#ifdef OS_linux
+// The child process inherits the state of the parent. Everything the other
+// threads did before fork() happens-before the child, so there is no race
+// on GLOB in the child.
+int GLOB;
+int pipe_fds[2];
+
+void Worker() {
+  GLOB = 1;
+  // Keep running while the main thread forks.
+  char c;
+  CHECK(1 == read(pipe_fds[0], &c, 1));
+}
+
+TEST(NegativeTests, ForkInheritsStateTest) {
+  CHECK(0 == pipe(pipe_fds));
+  MyThread t(Worker);
+  t.Start();
+  usleep(100000);
+  pid_t pid = fork();
+  if (pid == 0) {
+    // in child
+    GLOB = 2;
+    _exit(0);
+  }
+  CHECK(pid > 0);
+  CHECK(1 == write(pipe_fds[1], "x", 1));
+  t.Join();
+  int status = 0;
+  CHECK(pid == waitpid(pid, &status, 0));
+  CHECK(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+  close(pipe_fds[0]);
+  close(pipe_fds[1]);
+}
+#endif  // OS_linux
+}  // namespace
+
 TEST(WeirdSizesTests, FegetenvTest) {
   // http://code.google.com/p/data-race-test/issues/detail?id=36
   fenv_t tmp;
@@ -1159,6 +1198,59 @@ TEST(NegativeTests,epollTest) {
 }
 #endif  // OS_linux
 }
+
+namespace PositiveTests_epollPerRegistration {  // {{{1
+#ifdef OS_linux
+int GLOB;
+int epfd = -1;
+int idle_sockets[2];
+int ready_sockets[2];
+
+// epoll_wait() should synchronize only with the registrations it reports
+// ready. Worker1 registers a socket that never becomes readable,
+// so there is no hb arc between Worker1 and Worker2.
+
+void Worker1() {
+  struct epoll_event event;
+  event.events = EPOLLIN;
+  event.data.fd = idle_sockets[0];
+  GLOB++;
+  int res = epoll_ctl(epfd, EPOLL_CTL_ADD, idle_sockets[0], &event);
+  CHECK(res == 0);
+}
+void Worker2() {
+  usleep(100000);
+  struct epoll_event event;
+  event.events = EPOLLIN;
+  event.data.fd = ready_sockets[0];
+  int res = epoll_ctl(epfd, EPOLL_CTL_ADD, ready_sockets[0], &event);
+  CHECK(res == 0);
+  res = epoll_wait(epfd, &event, 1, -1);
+  CHECK(res == 1);
+  CHECK(event.data.fd == ready_sockets[0]);
+  GLOB++;
+}
+
+TEST(PositiveTests, epollPerRegistrationTest) {
+  ANNOTATE_EXPECT_RACE(&GLOB, "epoll: no hb arc from an idle registration");
+  epfd = epoll_create(10);
+  CHECK(epfd != -1);
+  CHECK(0 == socketpair(AF_UNIX, SOCK_STREAM, 0, idle_sockets));
+  CHECK(0 == socketpair(AF_UNIX, SOCK_STREAM, 0, ready_sockets));
+  CHECK(2 == send(ready_sockets[1], "Hi", 2, 0));
+  MyThreadArray mta(Worker1, Worker2);
+  mta.Start();
+  mta.Join();
+  for (int i = 0; i < 2; i++) {
+    close(idle_sockets[i]);
+    close(ready_sockets[i]);
+  }
+  close(epfd);
+  epfd = -1;
+}
+#endif  // OS_linux
+}
+
 namespace NegativeTests_LockfTest {  // {{{1
 
 class ShmMutex {
@@ -1394,5 +1486,139 @@ TEST(NegativeTests, DISABLED_MktimeTest) {
 }
 }  // namespace
 
+// NegativeTests.SemaphoreAndSpinLockTest: TN. {{{1
+// Semaphores and spin locks are handled as light-weight sync objects.
+// Checks the release paths that replace, keep and join the stored VTS:
+// a ping-pong hand-off, several posters on one semaphore and a counter
+// guarded by a spin lock. None of these should be reported as a race.
+#ifndef ANDROID
+namespace NegativeTests_SemaphoreAndSpinLockTest {
+const int kNumIter = 1000;
+const int kNumPosters = 3;
+int GLOB = 0;
+int SLOTS[kNumPosters];
+int n_posters = 0;
+Mutex n_posters_mu;
+sem_t full, empty;
+SpinLock *spin;
+
+void Producer() {
+  for (int i = 1; i <= kNumIter; i++) {
+    sem_wait(&empty);
+    GLOB = i;
+    sem_post(&full);
+  }
+}
+
+void Consumer() {
+  for (int i = 1; i <= kNumIter; i++) {
+    sem_wait(&full);
+    CHECK(GLOB == i);
+    sem_post(&empty);
+  }
+}
+
+void Poster() {
+  n_posters_mu.Lock();
+  int idx = n_posters++;
+  n_posters_mu.Unlock();
+  SLOTS[idx] = idx + 1;
+  sem_post(&full);
+}
+
+void Collector() {
+  for (int i = 0; i < kNumPosters; i++)
+    sem_wait(&full);
+  for (int i = 0; i < kNumPosters; i++)
+    CHECK(SLOTS[i] == i + 1);
+}
+
+void SpinWorker() {
+  for (int i = 0; i < kNumIter; i++) {
+    spin->Lock();
+    GLOB++;
+    spin->Unlock();
+  }
+}
+
+TEST(NegativeTests, SemaphoreAndSpinLockTest) {
+#ifndef NO_UNNAMED_SEM
+  sem_init(&full, 0, 0);
+  sem_init(&empty, 0, 1);
+  {
+    MyThreadArray t(Producer, Consumer);
+    t.Start();
+    t.Join();
+  }
+  {
+    MyThreadArray t(Poster, Poster, Poster, Collector);
+    t.Start();
+    t.Join();
+  }
+  sem_destroy(&full);
+  sem_destroy(&empty);
+#endif  // NO_UNNAMED_SEM
+  GLOB = 0;
+  spin = new SpinLock;
+  {
+    MyThreadArray t(SpinWorker, SpinWorker);
+    t.Start();
+    t.Join();
+  }
+  CHECK(GLOB == 2 * kNumIter);
+  delete spin;
+}
+}  // namespace
+
+// StressTests.SemaphoreAndSpinLockThroughput: sync events/sec. {{{1
+// A microbenchmark for the semaphore and spin lock handling.
+// Prints the number of synchronization events per second for each primitive.
+namespace StressTests_SemaphoreAndSpinLockThroughput {
+const int kNumIter = 100000;
+int GLOB = 0;
+sem_t sem;
+SpinLock *spin;
+
+void SemWorker() {
+  for (int i = 0; i < kNumIter; i++) {
+    sem_post(&sem);
+    sem_wait(&sem);
+  }
+}
+
+void SpinWorker() {
+  for (int i = 0; i < kNumIter; i++) {
+    spin->Lock();
+    GLOB++;
+    spin->Unlock();
+  }
+}
+
+void Measure(const char *name, void (*worker)(void)) {
+  int start = GetTimeInMs();
+  MyThreadArray t(worker, worker);
+  t.Start();
+  t.Join();
+  int elapsed = GetTimeInMs() - start;
+  // Two threads, two events per iteration.
+  int n_events = 2 * 2 * kNumIter;
+  printf("\t%s: %d events in %d ms (%.0f events/sec)\n", name, n_events,
+         elapsed, n_events * 1000.0 / (elapsed ? elapsed : 1));
+}
+
+TEST(StressTests, SemaphoreAndSpinLockThroughput) {
+#ifndef NO_UNNAMED_SEM
+  sem_init(&sem, 0, 0);
+  Measure("sem_post/sem_wait", SemWorker);
+  sem_destroy(&sem);
+#endif  // NO_UNNAMED_SEM
+  spin = new SpinLock;
+  Measure("pthread_spin_lock/unlock", SpinWorker);
+  CHECK(GLOB == 2 * kNumIter);
+  delete spin;
+}
+}  // namespace
+#endif  // ANDROID
+
 // End {{{1
  // vim:shiftwidth=2:softtabstop=2:expandtab:foldmethod=marker
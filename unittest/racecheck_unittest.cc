@@ -5708,6 +5708,29 @@ TEST(StressTests, DifferentSizeAccessStressTest) {
   t.Start();
   t.Join();
 }
+
+// Same, but every iteration also does aligned 8-byte accesses, so the
+// shadow values of split_join_arr are split and joined back all the time.
+const int kSplitJoinArrSize = 5;
+uint64_t split_join_arr[kSplitJoinArrSize];
+
+void SplitJoinStressWorker() {
+  const int n = 10000;
+  char foo[kStressArrSize];
+  memset(foo, 0, sizeof(foo));
+  char *arr = (char*)split_join_arr;
+  for (int i = 0; i < n; i++) {
+    memcpy(arr + i % 13, foo, 1 + i % 11);
+    split_join_arr[i % kSplitJoinArrSize] = i;
+  }
+}
+
+TEST(StressTests, DifferentSizeAccessSplitJoinStressTest) {
+  ANNOTATE_BENIGN_RACE_SIZED(split_join_arr, sizeof(split_join_arr), "race");
+  MyThreadArray t(SplitJoinStressWorker, SplitJoinStressWorker);
+  t.Start();
+  t.Join();
+}
 }  // namespace
 
 // test124: What happens if we delete an unlocked lock? {{{1
@@ -6867,6 +6890,43 @@ TEST(StressTests, StartAndJoinManyThreads) {
 }
 }  // namespace
 
+namespace StressTests_ReuseTidsOfJoinedThreads {  //{{{1
+// Same as StartAndJoinManyThreads, but the threads touch the same memory.
+// The threads started after a join may reuse the tids of the joined ones;
+// the accesses of the joined threads still happen-before the new ones.
+int GLOB1, GLOB2;
+
+void Worker1() {
+  GLOB1++;
+}
+
+void Worker2() {
+  GLOB2++;
+}
+
+TEST(StressTests, ReuseTidsOfJoinedThreads) {
+  ANNOTATE_FLUSH_STATE();
+  GLOB1 = GLOB2 = 0;
+  for (int i = 0; i < 1100; i++) {
+    if ((i % 100) == 0)
+      printf(".");
+    MyThread t1(Worker1);
+    MyThread t2(Worker2);
+    t1.Start();
+    t2.Start();
+    t1.Join();
+    t2.Join();
+    GLOB1++;
+  }
+  printf("\n");
+  CHECK(GLOB1 == 2200);
+  CHECK(GLOB2 == 1100);
+  if (ThreadSanitizerQueryMatch("reuse_tids", "1")) {
+    CHECK(atoi(ThreadSanitizerQuery("n_tids_reused")) > 0);
+  }
+}
+}  // namespace
+
 namespace StressTests_ManyAccesses {  // {{{1
 #ifndef NO_BARRIER
 const int kArrayLen = 128;  // Small size, so that everything fits into cache.